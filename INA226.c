@@ -34,35 +34,37 @@ Modified in 11.2020 by Norbert Gal for better portability, some bugs fixed.
 
 #include "INA226.h"
 #include "INA226_callback.h"
-#include <math.h>
+#include "INA226_ring.h"
+#include "INA226_energy.h"
+#include "INA226_internal.h"
+#include <stddef.h>
 
 
 
 //=============================================================================
 //Some helper macros for this source file
 
-#define CALL_FN(fn); { status s = fn; if(fn != OK){return s;} }
 #define CHECK_INITIALIZED(); if(!this->mInitialized) return NOT_INITIALIZED;
 
 //=============================================================================
 
-static const uint8_t    INA226_CONFIG              = 0x00;
-static const uint8_t    INA226_SHUNT_VOLTAGE       = 0x01; // readonly
-static const uint8_t    INA226_BUS_VOLTAGE         = 0x02; // readonly
-static const uint8_t    INA226_POWER               = 0x03; // readonly
-static const uint8_t    INA226_CURRENT             = 0x04; // readonly
-static const uint8_t    INA226_CALIBRATION         = 0x05;
-static const uint8_t    INA226_MASK_ENABLE         = 0x06;
-static const uint8_t    INA226_ALERT_LIMIT         = 0x07;
-static const uint8_t    INA226_MANUFACTURER_ID     = 0xFE; // readonly
-static const uint8_t    INA226_DIE_ID              = 0xFF; // readonly
+static const uint8_t    INA226_CONFIG              = INA226_CONFIG_REG;
+static const uint8_t    INA226_SHUNT_VOLTAGE       = INA226_SHUNT_VOLTAGE_REG; // readonly
+static const uint8_t    INA226_BUS_VOLTAGE         = INA226_BUS_VOLTAGE_REG; // readonly
+static const uint8_t    INA226_POWER               = INA226_POWER_REG; // readonly
+static const uint8_t    INA226_CURRENT             = INA226_CURRENT_REG; // readonly
+static const uint8_t    INA226_CALIBRATION         = INA226_CALIBRATION_REG;
+static const uint8_t    INA226_MASK_ENABLE         = INA226_MASK_ENABLE_REG;
+static const uint8_t    INA226_ALERT_LIMIT         = INA226_ALERT_LIMIT_REG;
+static const uint8_t    INA226_MANUFACTURER_ID     = INA226_MANUFACTURER_ID_REG; // readonly
+static const uint8_t    INA226_DIE_ID              = INA226_DIE_ID_REG; // readonly
 
 
 //=============================================================================
 
-static const int32_t    INA226_BUS_VOLTAGE_LSB     = 1250; //1250uV per bit
+static const int32_t    INA226_BUS_VOLTAGE_LSB     = INA226_BUS_VOLTAGE_LSB_UV; //1250uV per bit
 //static const int32_t    INA226_SHUNT_VOLTAGE_LSB   = 2500;    //2500 nano volts per bit (=2.5uV)
-static const int32_t    INA226_POWER_LSB_FACTOR    = 25;
+static const int32_t    INA226_POWER_LSB_FACTOR    = INA226_POWER_LSB_RATIO;
 static const uint16_t   INA226_MANUFACTURER_ID_K   = 0x5449;
 static const uint16_t   INA226_DIE_ID_K            = 0x2260;
 //static const uint16_t   INA226_CONFIG_RESET_VALUE  = 0x4127; // value of config reg after a reset
@@ -76,6 +78,8 @@ const uint16_t cOperatingModeMask           = 0x0007;
 const uint16_t cAlertPinModeMask            = 0xFC00;
 const uint16_t cAlertCauseMask              = 0x001E;
 const uint16_t cAlertLatchingMode           = 0x0001;
+const uint16_t cMaskEnableWritableMask      = 0xFC03; //alert function bits, polarity and latch enable
+const uint16_t cConfigResetValue            = 0x4127; //value of the config reg after a reset
 const uint16_t cSampleAvgMask               = 0x0E00;
 const uint16_t cBusVoltageConvTimeMask      = 0x01C0;
 const uint16_t cShuntVoltageConvTimeMask    = 0x0038;
@@ -84,222 +88,1515 @@ const int      cBusVoltConvTimeIdxShift     = 6;
 const int      cShuntVoltConvTimeIdxShift   = 3;
 const int      cMaxSampleAvgTblIdx          = 7;    //occupies 3 bit positions
 const int      cMaxConvTimeTblIdx           = 7; //occupies 3 bit positions
+const uint16_t cShuntConversionEnabled      = 0x0001; //bits of the operating mode
+const uint16_t cBusConversionEnabled        = 0x0002;
+const uint32_t cTriggerPollsPerConversion   = 16;
+const uint8_t  cAlertRetries                = 3;  //failed conversion ready reads in a row retried right away
+const uint32_t cLongestTransferBits         = 5 * 9 + 3;
+
+enum {TriggerIdle = 0, TriggerWriting, TriggerWaiting, TriggerReading}; //INA226_acquisition.mTriggerState
+
+const uint16_t caNumSamplesAveraged[8]       = {1, 4, 16, 64, 128, 256, 512, 1024};
+const uint16_t caVoltageConvTimeMicroSecs[8] = {140, 204, 332, 588, 1100, 2116, 4156, 8244};
 //=============================================================================
 
 void INA226_Constructor(INA226_config* this, void* i2c_device, uint8_t aI2C_Address)
 {
 	this->mInitialized = false;
 	this->hi2c = i2c_device;
+	this->mTransport = &INA226_DefaultTransport;
 	this->mI2C_Address = aI2C_Address;
 	this->mConfigRegister = 0;
 	this->mCalibrationValue = 0;
 	this->mCurrentMicroAmpsPerBit = 0;
 	this->mPowerMicroWattPerBit = 0;
+	this->mRegisterPointer = 0;
+	this->mRegisterPointerValid = false;
+	this->mStreamingReads = false;
+	this->mBusTransactions = 0;
+	this->mI2C_Timeout = INA226_I2C_TIMEOUT;
+	this->mRetries = 0;
+	this->mProbeTrials = INA226_PROBE_TRIALS;
+	this->mDegradeAfter = 0;
+	this->mFailures = 0;
+	this->mDegraded = false;
+	this->mMaskEnableRegister = 0;
+	this->mAlertLimitRegister = 0;
+	this->mOperatingModeBeforeHibernate = 0;
+	this->mTrustCache = false;
+#ifdef INA226_TRACE
+	this->mTracer = NULL;
+	INA226_ResetStats(this);
+#endif
+}
+
+//----------------------------------------------------------------------------
+//Instrumentation of the bus wrappers below, compiled out without INA226_TRACE
+
+#ifdef INA226_TRACE
+static uint32_t INA226_TraceBegin(INA226_config* this, uint8_t aEvent, uint8_t aRegister)
+{
+	uint32_t theStart = INA226_TRACE_CYCLES();
+	if(this->mTracer != NULL){
+		this->mTracer(this, aEvent | TraceBegin, aRegister, 0, theStart);
+	}
+	return theStart;
+}
+
+static void INA226_TraceEnd(INA226_config* this, uint8_t aEvent, uint8_t aRegister, uint16_t aSize, int aResult, uint32_t aStart)
+{
+	uint32_t theCycles = INA226_TRACE_CYCLES() - aStart;
+	INA226_stats* theStats = &this->mStats;
+	theStats->mTransactions++;
+	theStats->mBytes += 1 + aSize;
+	theStats->mTotalCycles += theCycles;
+	if(aResult != 0){
+		theStats->mErrors++;
+		if(aResult == INA226_TRACE_TIMEOUT_RESULT){
+			theStats->mTimeouts++;
+		}
+	}
+	if(theCycles > theStats->mWorstCycles){
+		theStats->mWorstCycles = theCycles;
+		theStats->mWorstEvent = aEvent;
+		theStats->mWorstRegister = aRegister;
+	}
+	if(this->mTracer != NULL){
+		this->mTracer(this, aEvent, aRegister, aResult, theCycles);
+	}
+}
+
+//Async transfers end in INA226_AsyncTransferComplete / INA226_AsyncTransferError
+static void INA226_TraceAsyncBegin(INA226_config* this, uint8_t aEvent, uint8_t aRegister, uint16_t aSize)
+{
+	this->mStats.mAsyncEvent = aEvent;
+	this->mStats.mAsyncRegister = aRegister;
+	this->mStats.mAsyncBytes = aSize;
+	this->mStats.mAsyncStart = INA226_TraceBegin(this, aEvent, aRegister);
+}
+
+static void INA226_TraceAsyncEnd(INA226_config* this, int aResult)
+{
+	if(this->mStats.mAsyncEvent != 0){
+		INA226_TraceEnd(this, this->mStats.mAsyncEvent, this->mStats.mAsyncRegister, this->mStats.mAsyncBytes, aResult, this->mStats.mAsyncStart);
+		this->mStats.mAsyncEvent = 0;
+	}
+}
+
+#define TRACE_BEGIN(aEvent, aRegister)					uint32_t theTraceStart = INA226_TraceBegin(this, aEvent, aRegister)
+#define TRACE_END(aEvent, aRegister, aSize, aResult)	INA226_TraceEnd(this, aEvent, aRegister, aSize, aResult, theTraceStart)
+#define TRACE_ASYNC_BEGIN(aEvent, aRegister, aSize)		INA226_TraceAsyncBegin(this, aEvent, aRegister, aSize)
+#define TRACE_ASYNC_END(aConfig, aResult)				INA226_TraceAsyncEnd(aConfig, aResult)
+#define TRACE_ASYNC_FAILED(aResult)						{ if(aResult != 0) INA226_TraceAsyncEnd(this, aResult); }
+#else
+#define TRACE_BEGIN(aEvent, aRegister)
+#define TRACE_END(aEvent, aRegister, aSize, aResult)
+#define TRACE_ASYNC_BEGIN(aEvent, aRegister, aSize)
+#define TRACE_ASYNC_END(aConfig, aResult)
+#define TRACE_ASYNC_FAILED(aResult)
+#endif
+
+//----------------------------------------------------------------------------
+//Thin wrappers around the transport of the instance, every bus access of the driver goes through these.
+//Each call is one bus transaction (address phase), counted in mBusTransactions.
+//The async ones are also used by the modules that drive the transport themselves (INA226_internal.h).
+
+static int INA226_BusTransmit(INA226_config* this, uint8_t* aData, uint16_t Size)
+{
+	this->mBusTransactions++;
+	TRACE_BEGIN(TraceTransmit, aData[0]);
+	int theResult = this->mTransport->Transmit(this, aData, Size);
+	TRACE_END(TraceTransmit, aData[0], Size, theResult);
+	return theResult;
+}
+
+static int INA226_BusReceive(INA226_config* this, uint8_t* buffer, uint16_t Size)
+{
+	this->mBusTransactions++;
+	TRACE_BEGIN(TraceReceive, this->mRegisterPointer);
+	int theResult = this->mTransport->Receive(this, buffer, Size);
+	TRACE_END(TraceReceive, this->mRegisterPointer, Size, theResult);
+	return theResult;
+}
+
+static int INA226_BusWriteRead(INA226_config* this, uint8_t aRegister, uint8_t* buffer, uint16_t Size)
+{
+	this->mBusTransactions++;
+	TRACE_BEGIN(TraceWriteRead, aRegister);
+	int theResult = this->mTransport->WriteRead(this, aRegister, buffer, Size);
+	TRACE_END(TraceWriteRead, aRegister, 2 + Size, theResult); //register, repeated START + address, data
+	return theResult;
+}
+
+static int INA226_BusCheckDevice(INA226_config* this, uint8_t aI2C_Address, uint32_t Trials)
+{
+	if(this->mTransport->Check_device == NULL){
+		return 0; //Not mandatory, assume the device is there
+	}
+	this->mBusTransactions++;
+	TRACE_BEGIN(TraceCheckDevice, 0);
+	int theResult = this->mTransport->Check_device(this, aI2C_Address, Trials);
+	TRACE_END(TraceCheckDevice, 0, 0, theResult);
+	return theResult;
+}
+
+int INA226_BusReadRegisterAsync(INA226_config* this, uint8_t aRegister, uint8_t* buffer, uint16_t Size)
+{
+	this->mBusTransactions++;
+	TRACE_ASYNC_BEGIN(TraceReadRegisterAsync, aRegister, 2 + Size);
+	int theResult = this->mTransport->ReadRegister_Async(this, aRegister, buffer, Size);
+	TRACE_ASYNC_FAILED(theResult);
+	return theResult;
+}
+
+static int INA226_BusTransmitAsync(INA226_config* this, uint8_t* aData, uint16_t Size)
+{
+	if(this->mTransport->Transmit_Async == NULL){
+		return -1;
+	}
+	this->mBusTransactions++;
+	TRACE_ASYNC_BEGIN(TraceTransmitAsync, aData[0], Size);
+	int theResult = this->mTransport->Transmit_Async(this, aData, Size);
+	TRACE_ASYNC_FAILED(theResult);
+	return theResult;
+}
+
+int INA226_BusReceiveAsync(INA226_config* this, uint8_t* buffer, uint16_t Size)
+{
+	if(this->mTransport->Receive_Async == NULL){
+		return -1;
+	}
+	this->mBusTransactions++;
+	TRACE_ASYNC_BEGIN(TraceReceiveAsync, this->mRegisterPointer, Size);
+	int theResult = this->mTransport->Receive_Async(this, buffer, Size);
+	TRACE_ASYNC_FAILED(theResult);
+	return theResult;
+}
+
+void INA226_BusAsyncEnd(INA226_config* this, int aResult)
+{
+	TRACE_ASYNC_END(this, aResult);
+}
+
+//----------------------------------------------------------------------------
+#ifndef INA226_NO_FLOAT
+//Only converts to micro units, the calibration itself is integer (no libm needed)
+static uint32_t INA226_ToMicroUnits(double aValue)
+{
+	if(aValue <= 0.0){
+		return 0;
+	}
+	return (uint32_t)(aValue * 1000000.0 + 0.5);
+}
+
+status INA226_Init(INA226* this, void* i2c_device, uint8_t aI2C_Address, double aShuntResistor_Ohms, double aMaxCurrent_Amps)
+{
+	return INA226_InitWithTransport(this, &INA226_DefaultTransport, i2c_device, aI2C_Address, aShuntResistor_Ohms, aMaxCurrent_Amps);
+}
+//----------------------------------------------------------------------------
+status INA226_InitWithTransport(INA226* this, const INA226_transport* aTransport, void* i2c_device, uint8_t aI2C_Address, double aShuntResistor_Ohms, double aMaxCurrent_Amps)
+{
+	return INA226_InitFixedPoint(this, aTransport, i2c_device, aI2C_Address,
+		INA226_ToMicroUnits(aShuntResistor_Ohms), INA226_ToMicroUnits(aMaxCurrent_Amps));
+}
+//----------------------------------------------------------------------------
+status INA226_setupCalibration(INA226_config* this, double aShuntResistor_Ohms, double aMaxCurrent_Amps)
+{
+	return INA226_setupCalibrationFixedPoint(this, INA226_ToMicroUnits(aShuntResistor_Ohms), INA226_ToMicroUnits(aMaxCurrent_Amps));
+}
+#endif //INA226_NO_FLOAT
+//----------------------------------------------------------------------------
+//Sets up the whole instance (config, async and acquisition state) for a device at aI2C_Address
+static void INA226_InstanceConstructor(INA226* this, const INA226_transport* aTransport, void* i2c_device, uint8_t aI2C_Address)
+{
+	INA226_Constructor(&this->Config, i2c_device, aI2C_Address);
+	this->Config.mTransport = aTransport;
+	this->Async.mState = AsyncIdle;
+	this->Async.mOnComplete = NULL;
+	this->Async.mUserData = NULL;
+	this->Async.mBus = NULL;
+	this->Async.mSupervisor = NULL;
+	this->Async.mOsal = NULL;
+	this->Async.mProbing = false;
+	this->Acquisition.mRunning = false;
+	this->Acquisition.mRing = NULL;
+	this->Acquisition.mOnSample = NULL;
+	this->Acquisition.mClock = NULL;
+	this->Acquisition.mEnergy = NULL;
+	this->Acquisition.mConfigPending = false;
+	this->Acquisition.mAlertPending = false;
+	this->Acquisition.mTriggerState = TriggerIdle;
+}
+
+//The steps of the initialization, shared by INA226_Init and INA226_Enumerate
+
+//Check that it's an INA226 device at the address
+static status INA226_Identify(INA226_config* this)
+{
+	uint16_t theINA226_ID;
+	CALL_FN( INA226_ReadRegister(this,INA226_MANUFACTURER_ID, &theINA226_ID) );
+	if(theINA226_ID != INA226_MANUFACTURER_ID_K){
+		return INA226_TI_ID_MISMATCH; //Expected to find TI manufacturer ID
+	}
+	CALL_FN( INA226_ReadRegister(this,INA226_DIE_ID, &theINA226_ID) );
+	if( theINA226_ID != INA226_DIE_ID_K){
+		return  INA226_DIE_ID_MISMATCH; //Expected to find INA226 device ID
+	}
+	return OK;
+}
+
+static status INA226_WriteInitialConfig(INA226_config* this, uint16_t aConfigRegister)
+{
+	//Now set our own default configuration (you can redefine INA226_CONFIG_DEFAULT above, as needed)
+	return INA226_WriteRegister(this,INA226_CONFIG, aConfigRegister);
+}
+
+static status INA226_VerifyConfig(INA226_config* this, uint16_t aConfigRegister)
+{
+	//Read back the configuration register and check that it matches
+	CALL_FN( INA226_ReadRegister(this,INA226_CONFIG, &(this->mConfigRegister)) );
+	if(this->mConfigRegister != aConfigRegister){
+		return CONFIG_ERROR;
+	}
+	return OK;
+}
+
+static status INA226_ApplyCalibration(INA226_config* this, uint16_t aCalibrationValue, int32_t aCurrentMicroAmpsPerBit)
+{
+	this->mCurrentMicroAmpsPerBit = aCurrentMicroAmpsPerBit;
+	this->mCalibrationValue = aCalibrationValue;
+	this->mPowerMicroWattPerBit = this->mCurrentMicroAmpsPerBit * INA226_POWER_LSB_FACTOR;
+
+	return INA226_WriteRegister(this,INA226_CALIBRATION, this->mCalibrationValue);
+}
+
+//Checks the shunt/current combination and computes the calibration word
+static status INA226_ComputeCalibration(uint32_t aShuntResistor_uOhms, uint32_t aMaxCurrent_uA, uint16_t* aCalibrationValue_p, int32_t* aCurrentMicroAmpsPerBit_p)
+{
+	if(aShuntResistor_uOhms == 0 || aMaxCurrent_uA == 0){
+		return BAD_PARAMETER;
+	}
+	uint64_t theCal = INA226_CALIBRATION_VALUE_U64(aShuntResistor_uOhms, aMaxCurrent_uA);
+	if(theCal == 0 || theCal > INA226_CALIBRATION_MAX){
+		return BAD_PARAMETER; //the shunt/current combination can't be represented
+	}
+	*aCalibrationValue_p = (uint16_t)theCal;
+	*aCurrentMicroAmpsPerBit_p = (int32_t)INA226_CURRENT_LSB_UA(aMaxCurrent_uA);
+	return OK;
+}
+//----------------------------------------------------------------------------
+status INA226_InitFixedPoint(INA226* this, const INA226_transport* aTransport, void* i2c_device, uint8_t aI2C_Address, uint32_t aShuntResistor_uOhms, uint32_t aMaxCurrent_uA)
+{
+	uint16_t theCalibrationValue;
+	int32_t theCurrentMicroAmpsPerBit;
+	CALL_FN( INA226_ComputeCalibration(aShuntResistor_uOhms, aMaxCurrent_uA, &theCalibrationValue, &theCurrentMicroAmpsPerBit) );
+	return INA226_InitPrecomputed(this, aTransport, i2c_device, aI2C_Address, INA226_CONFIG_DEFAULT, theCalibrationValue, theCurrentMicroAmpsPerBit);
+}
+//----------------------------------------------------------------------------
+status INA226_InitPrecomputed(INA226* this, const INA226_transport* aTransport, void* i2c_device, uint8_t aI2C_Address,
+		uint16_t aConfigRegister, uint16_t aCalibrationValue, int32_t aCurrentMicroAmpsPerBit)
+{
+	if(aTransport == NULL){
+		aTransport = &INA226_DefaultTransport;
+	}
+	if(aTransport->Transmit == NULL || aTransport->Receive == NULL){
+		return BAD_PARAMETER;
+	}
+	INA226_InstanceConstructor(this, aTransport, i2c_device, aI2C_Address);
+
+	//Check if there's a device (any I2C device) at the specified address.
+	CALL_FN( INA226_CheckI2cAddress(&this->Config, aI2C_Address) );
+
+	//Good so far, check that it's an INA226 device at the specified address.
+	CALL_FN( INA226_Identify(&this->Config) );
+
+	//Reset the INA226 device
+	CALL_FN( INA226_WriteRegister(&this->Config,INA226_CONFIG, cResetCommand) );
+
+	CALL_FN( INA226_WriteInitialConfig(&this->Config, aConfigRegister) );
+	CALL_FN( INA226_VerifyConfig(&this->Config, aConfigRegister) );
+
+	//Finally, set up the calibration register and the scaling factors that we must
+	//apply to the current and power measurements that we read from the INA226 device.
+	CALL_FN( INA226_ApplyCalibration(&this->Config, aCalibrationValue, aCurrentMicroAmpsPerBit) );
+
+	this->Config.mInitialized = true;
+	return OK;
+}
+//----------------------------------------------------------------------------
+//Bus enumeration. Every address is probed once with a short timeout, so a missing device costs one
+//short probe instead of 10 trials with the full timeout. The accesses are blocking and run one
+//after another; they are only ordered step by step (all devices are reset before the first one is
+//configured), which gives every device the time of the others' accesses to come out of reset.
+//A device failing a step is left out of the following ones and dropped from the list.
+status INA226_Enumerate(INA226* aDevices, uint8_t aMaxDevices, const INA226_transport* aTransport, void* i2c_device,
+		uint32_t aShuntResistor_uOhms, uint32_t aMaxCurrent_uA, uint8_t* aFoundCount_p)
+{
+	*aFoundCount_p = 0;
+	if(aTransport == NULL){
+		aTransport = &INA226_DefaultTransport;
+	}
+	if(aTransport->Transmit == NULL || aTransport->Receive == NULL){
+		return BAD_PARAMETER;
+	}
+	uint16_t theCalibrationValue;
+	int32_t theCurrentMicroAmpsPerBit;
+	CALL_FN( INA226_ComputeCalibration(aShuntResistor_uOhms, aMaxCurrent_uA, &theCalibrationValue, &theCurrentMicroAmpsPerBit) );
+
+	//Probe
+	uint8_t theCount = 0;
+	for(uint8_t theAddress = INA226_ADRESS_0; theAddress <= INA226_ADRESS_15 && theCount < aMaxDevices; theAddress++){
+		INA226* theDevice = &aDevices[theCount];
+		INA226_InstanceConstructor(theDevice, aTransport, i2c_device, theAddress);
+		theDevice->Config.mI2C_Timeout = INA226_PROBE_TIMEOUT;
+		if(INA226_BusCheckDevice(&theDevice->Config, theAddress, 1) == 0){
+			theDevice->Config.mI2C_Timeout = INA226_I2C_TIMEOUT;
+			theCount++;
+		}
+	}
+
+	//Identify, drop what isn't an INA226 (keep the list packed)
+	uint8_t theFound = 0;
+	for(uint8_t i = 0; i < theCount; i++){
+		if(INA226_Identify(&aDevices[i].Config) == OK){
+			if(theFound != i){
+				aDevices[theFound] = aDevices[i];
+			}
+			theFound++;
+		}
+	}
+
+	//Reset all, then configure all, then check and calibrate all
+	status theStatus[INA226_ADRESS_15 - INA226_ADRESS_0 + 1];
+	for(uint8_t i = 0; i < theFound; i++){
+		theStatus[i] = INA226_WriteRegister(&aDevices[i].Config,INA226_CONFIG, cResetCommand);
+	}
+	for(uint8_t i = 0; i < theFound; i++){
+		if(theStatus[i] == OK){
+			theStatus[i] = INA226_WriteInitialConfig(&aDevices[i].Config, INA226_CONFIG_DEFAULT);
+		}
+	}
+	for(uint8_t i = 0; i < theFound; i++){
+		if(theStatus[i] == OK){
+			theStatus[i] = INA226_VerifyConfig(&aDevices[i].Config, INA226_CONFIG_DEFAULT);
+		}
+		if(theStatus[i] == OK){
+			theStatus[i] = INA226_ApplyCalibration(&aDevices[i].Config, theCalibrationValue, theCurrentMicroAmpsPerBit);
+		}
+	}
+
+	//Keep the initialized ones (packed), the others stay uninitialized
+	uint8_t theInitialized = 0;
+	for(uint8_t i = 0; i < theFound; i++){
+		if(theStatus[i] != OK){
+			continue;
+		}
+		if(theInitialized != i){
+			aDevices[theInitialized] = aDevices[i];
+		}
+		aDevices[theInitialized].Config.mInitialized = true;
+		theInitialized++;
+	}
+
+	*aFoundCount_p = theInitialized;
+	return OK;
+}
+//----------------------------------------------------------------------------
+
+status INA226_setupCalibrationFixedPoint(INA226_config* this, uint32_t aShuntResistor_uOhms, uint32_t aMaxCurrent_uA)
+{
+	// Calculate a value for Current_LSB that gives us the best resolution
+	// for current measurements.  The INA266 current register is 16-bit
+	// signed, max positive value is 2^15 -1 = 32767
+	// If we can be sure that the current won't be more than aMaxCurrent_uA then
+	// we can calculate the micro Amps per bit as aMaxCurrent_uA/32767 (rounded up to
+	// to the nearest integer).
+	// The value 0.00512 in the calculations comes from the INA226 spec which
+	// provides a definition of the formula that's used to calculate the calibration value,
+	// see INA226_CALIBRATION_VALUE in the header.
+
+	uint16_t theCalibrationValue;
+	int32_t theCurrentMicroAmpsPerBit;
+	CALL_FN( INA226_ComputeCalibration(aShuntResistor_uOhms, aMaxCurrent_uA, &theCalibrationValue, &theCurrentMicroAmpsPerBit) );
+	return INA226_ApplyCalibration(this, theCalibrationValue, theCurrentMicroAmpsPerBit);
+}
+//----------------------------------------------------------------------------
+//Check if a device exists at the specified I2C address
+
+status INA226_CheckI2cAddress(INA226_config* this, uint8_t aI2C_Address)
+{
+	if(INA226_BusCheckDevice(this, aI2C_Address, this->mProbeTrials) != 0){ //Return 0 is OK
+		return INVALID_I2C_ADDRESS;
+	}else{
+		return OK;
+	}
+}
+
+//----------------------------------------------------------------------------
+
+//The register pointer is latched in the INA226, so a read of the same register as the last
+//access doesn't need a new pointer write (only used in streaming mode).
+static bool INA226_PointerIsLatched(INA226_config* this, uint8_t aRegister)
+{
+	return this->mStreamingReads && this->mRegisterPointerValid && this->mRegisterPointer == aRegister;
+}
+
+static void INA226_UpdatePointer(INA226_config* this, uint8_t aRegister, bool aSuccess)
+{
+	this->mRegisterPointer = aRegister;
+	this->mRegisterPointerValid = aSuccess;
+}
+
+//Write-through/read-through shadow of the configuration registers
+static void INA226_UpdateShadow(INA226_config* this, uint8_t aRegister, uint16_t aValue)
+{
+	if(aRegister == INA226_CONFIG){
+		if(aValue & cResetCommand){
+			//A reset puts every register back to its power-on value
+			this->mConfigRegister = cConfigResetValue;
+			this->mCalibrationValue = 0;
+			this->mMaskEnableRegister = 0;
+			this->mAlertLimitRegister = 0;
+		}else{
+			this->mConfigRegister = aValue;
+		}
+	}else if(aRegister == INA226_CALIBRATION){
+		this->mCalibrationValue = aValue;
+	}else if(aRegister == INA226_MASK_ENABLE){
+		//The low bits are status flags, only keep the settings
+		this->mMaskEnableRegister = aValue & cMaskEnableWritableMask;
+	}else if(aRegister == INA226_ALERT_LIMIT){
+		this->mAlertLimitRegister = aValue;
+	}
+}
+
+//Makes sure the shadow of aRegister is up to date: reads it from the chip unless the cache is trusted
+static status INA226_RefreshShadow(INA226_config* this, uint8_t aRegister)
+{
+	if(this->mTrustCache){
+		return OK;
+	}
+	uint16_t theValue;
+	return INA226_ReadRegister(this, aRegister, &theValue);
+}
+
+//----------------------------------------------------------------------------
+
+//Read without updating the shadow
+static status INA226_ReadRegisterRaw(INA226_config* this, uint8_t aRegister, uint16_t* aValue_p)
+{
+	*aValue_p = 0;
+
+	uint8_t buffer[2];
+	int theResult;
+	if(INA226_PointerIsLatched(this, aRegister)){
+		theResult = INA226_BusReceive(this, buffer, 2);
+	}else if(this->mTransport->WriteRead != NULL){
+		theResult = INA226_BusWriteRead(this, aRegister, buffer, 2);
+	}else{
+		theResult = INA226_BusTransmit(this, &aRegister, 1);
+		if(theResult == 0){
+			theResult = INA226_BusReceive(this, buffer, 2);
+		}
+	}
+	INA226_UpdatePointer(this, aRegister, theResult == 0);
+	if (theResult != 0) {	//Return 0 is OK
+		return FAIL;
+	}
+	*aValue_p = buffer[0];
+	*aValue_p = *aValue_p<<8 | buffer[1];
+	return OK;
+}
+
+static status INA226_ReadRegisterOnce(INA226_config* this, uint8_t aRegister, uint16_t* aValue_p)
+{
+	CALL_FN( INA226_ReadRegisterRaw(this, aRegister, aValue_p) );
+	INA226_UpdateShadow(this, aRegister, *aValue_p);
+	return OK;
+}
+
+//----------------------------------------------------------------------------
+//Counts the consecutive failures of the register accesses, degrades the device after mDegradeAfter
+status INA226_AccountAccess(INA226_config* this, status aStatus)
+{
+	if(aStatus == OK){
+		this->mFailures = 0;
+	}else if(this->mFailures < 0xFF && ++this->mFailures >= this->mDegradeAfter && this->mDegradeAfter != 0){
+		this->mDegraded = true;
+	}
+	return aStatus;
+}
+
+#ifdef INA226_TRACE
+#define TRACE_RETRY()	this->mStats.mRetries++
+#else
+#define TRACE_RETRY()
+#endif
+
+status INA226_ReadRegister(INA226_config* this, uint8_t aRegister, uint16_t* aValue_p)
+{
+	if(this->mDegraded){
+		*aValue_p = 0;
+		return INA226_DEGRADED;
+	}
+	status s = INA226_ReadRegisterOnce(this, aRegister, aValue_p);
+	for(uint8_t i = 0; s != OK && i < this->mRetries; i++){
+		TRACE_RETRY();
+		s = INA226_ReadRegisterOnce(this, aRegister, aValue_p);
+	}
+	return INA226_AccountAccess(this, s);
+}
+
+//----------------------------------------------------------------------------
+static status INA226_WriteRegisterOnce(INA226_config* this, uint8_t aRegister, uint16_t aValue)
+{
+	uint8_t buffer[3];
+	buffer[0] = aRegister;
+	buffer[1] = (uint8_t) ((aValue >> 8) & 0xFF);
+	buffer[2] = (uint8_t) (aValue & 0xFF);
+	int theResult = INA226_BusTransmit(this, buffer, 3);
+	INA226_UpdatePointer(this, aRegister, theResult == 0);
+	if (theResult != 0) {				//Return 0 is OK
+		return FAIL;
+	}
+	INA226_UpdateShadow(this, aRegister, aValue);
+	return OK;
+}
+
+status INA226_WriteRegister(INA226_config* this, uint8_t aRegister, uint16_t aValue)
+{
+	if(this->mDegraded){
+		return INA226_DEGRADED;
+	}
+	status s = INA226_WriteRegisterOnce(this, aRegister, aValue);
+	for(uint8_t i = 0; s != OK && i < this->mRetries; i++){
+		TRACE_RETRY();
+		s = INA226_WriteRegisterOnce(this, aRegister, aValue);
+	}
+	return INA226_AccountAccess(this, s);
+}
+
+static status INA226_SetRegisterPointerOnce(INA226_config* this, uint8_t aRegister)
+{
+	int theResult = INA226_BusTransmit(this, &aRegister, 1);
+	INA226_UpdatePointer(this, aRegister, theResult == 0);
+	return theResult == 0 ? OK : FAIL;
+}
+
+status INA226_SetRegisterPointer(INA226_config* this, uint8_t aRegister)
+{
+	if(this->mDegraded){
+		return INA226_DEGRADED;
+	}
+	status s = INA226_SetRegisterPointerOnce(this, aRegister);
+	for(uint8_t i = 0; s != OK && i < this->mRetries; i++){
+		TRACE_RETRY();
+		s = INA226_SetRegisterPointerOnce(this, aRegister);
+	}
+	return INA226_AccountAccess(this, s);
+}
+//----------------------------------------------------------------------------
+status INA226_SetStreamingReads(INA226_config* this, bool aEnable)
+{
+	this->mStreamingReads = aEnable;
+	return OK;
+}
+//----------------------------------------------------------------------------
+status INA226_SetBusSpeed(INA226_config* this, uint32_t aBusSpeed_Hz)
+{
+	if(aBusSpeed_Hz == 0){
+		return BAD_PARAMETER;
+	}
+	//Longest transfer: pointer write + 2 byte read with repeated START, 5 bytes of 9 bits
+	//plus START / repeated START / STOP. Allow 4 times that, +1 for the millisecond tick granularity.
+	uint32_t theTransfer_us = (uint32_t)((cLongestTransferBits * 1000000ull + aBusSpeed_Hz - 1) / aBusSpeed_Hz);
+	this->mI2C_Timeout = (4 * theTransfer_us + 999) / 1000 + 1;
+	this->mProbeTrials = 2;
+	return OK;
+}
+//----------------------------------------------------------------------------
+status INA226_SetFailurePolicy(INA226_config* this, uint8_t aRetries, uint8_t aDegradeAfter)
+{
+	this->mRetries = aRetries;
+	this->mDegradeAfter = aDegradeAfter;
+	return OK;
+}
+//----------------------------------------------------------------------------
+bool INA226_IsDegraded(INA226_config* this)
+{
+	return this->mDegraded;
+}
+//----------------------------------------------------------------------------
+//The settings a reprobe restores. CALIBRATION is written last: it is what a reprobe compares, so a
+//partly restored device still differs and is restored again by the next one.
+static const uint8_t caRestoredRegisters[4] = {INA226_CONFIG_REG, INA226_MASK_ENABLE_REG, INA226_ALERT_LIMIT_REG, INA226_CALIBRATION_REG};
+
+static void INA226_SaveShadows(INA226_config* this, uint16_t* aValues)
+{
+	aValues[0] = this->mConfigRegister;
+	aValues[1] = this->mMaskEnableRegister;
+	aValues[2] = this->mAlertLimitRegister;
+	aValues[3] = this->mCalibrationValue;
+}
+
+static void INA226_RestoreShadows(INA226_config* this, const uint16_t* aValues)
+{
+	this->mConfigRegister = aValues[0];
+	this->mMaskEnableRegister = aValues[1];
+	this->mAlertLimitRegister = aValues[2];
+	this->mCalibrationValue = aValues[3];
+}
+
+status INA226_Reprobe(INA226_config* this)
+{
+	CHECK_INITIALIZED();
+	//Raw read: the shadows keep the values we expect the device to have
+	uint16_t theValue;
+	CALL_FN( INA226_ReadRegisterRaw(this, INA226_CALIBRATION, &theValue) );
+	if(theValue != this->mCalibrationValue){
+		//Power-on values, the device was reset: restore our settings
+		uint16_t theSaved[4];
+		INA226_SaveShadows(this, theSaved);
+		status s = OK;
+		for(uint8_t i = 0; i < 4 && s == OK; i++){
+			s = INA226_WriteRegisterOnce(this, caRestoredRegisters[i], theSaved[i]);
+		}
+		if(s != OK){
+			INA226_RestoreShadows(this, theSaved);
+			return s;
+		}
+	}
+	this->mFailures = 0;
+	this->mDegraded = false;
+	return OK;
+}
+#ifdef INA226_TRACE
+//----------------------------------------------------------------------------
+status INA226_SetTracer(INA226_config* this, INA226_TraceFn aTracer)
+{
+	this->mTracer = aTracer;
+	return OK;
+}
+//----------------------------------------------------------------------------
+void INA226_ResetStats(INA226_config* this)
+{
+	this->mStats.mTransactions = 0;
+	this->mStats.mBytes = 0;
+	this->mStats.mErrors = 0;
+	this->mStats.mTimeouts = 0;
+	this->mStats.mRetries = 0;
+	this->mStats.mTotalCycles = 0;
+	this->mStats.mWorstCycles = 0;
+	this->mStats.mWorstEvent = 0;
+	this->mStats.mWorstRegister = 0;
+	this->mStats.mAsyncEvent = 0;
+}
+#endif
+//----------------------------------------------------------------------------
+status INA226_SetTrustCache(INA226_config* this, bool aEnable)
+{
+	this->mTrustCache = aEnable;
+	return OK;
+}
+//----------------------------------------------------------------------------
+status INA226_ResyncShadowRegisters(INA226_config* this)
+{
+	uint16_t theValue;
+	//Reading the registers updates the shadow copies
+	CALL_FN( INA226_ReadRegister(this, INA226_CONFIG, &theValue) );
+	CALL_FN( INA226_ReadRegister(this, INA226_CALIBRATION, &theValue) );
+	CALL_FN( INA226_ReadRegister(this, INA226_MASK_ENABLE, &theValue) );
+	CALL_FN( INA226_ReadRegister(this, INA226_ALERT_LIMIT, &theValue) );
+	return OK;
+}
+//----------------------------------------------------------------------------
+//Conversion of the raw register values to micro units, shared by the blocking and
+//the asynchronous read paths.
+static int32_t INA226_ShuntVoltageFromRegister(int16_t aRegisterValue)
+{
+	//The value retrieved from the INA226 for the shunt voltage
+	//needs to be multiplied by 2.5 to yield the value in microvolts.
+	//As I don't want to use floating point multiplication I will take the value
+	//divide it by 2 (shift right) and add that to 2 times the original value
+	//(shift left).
+	int32_t theResult;
+	theResult = (int32_t)aRegisterValue>>1;
+	theResult+= (int32_t)aRegisterValue<<1;
+	return theResult;
+}
+
+static int32_t INA226_BusVoltageFromRegister(uint16_t aRegisterValue)
+{
+	return (int32_t)aRegisterValue * INA226_BUS_VOLTAGE_LSB;
+}
+
+static int32_t INA226_CurrentFromRegister(const INA226_config* this, int16_t aRegisterValue)
+{
+	return (int32_t)aRegisterValue * this->mCurrentMicroAmpsPerBit;
+}
+
+static int32_t INA226_PowerFromRegister(const INA226_config* this, uint16_t aRegisterValue)
+{
+	return (int32_t)aRegisterValue * this->mPowerMicroWattPerBit;
+}
+//----------------------------------------------------------------------------
+int32_t INA226_GetShuntVoltage_uV(INA226* this)
+{
+	int16_t theRegisterValue=0;
+	INA226_ReadRegister(&this->Config,INA226_SHUNT_VOLTAGE, (uint16_t*)&theRegisterValue);
+	return INA226_ShuntVoltageFromRegister(theRegisterValue);
+}
+//----------------------------------------------------------------------------
+int32_t INA226_GetBusVoltage_uV(INA226* this)
+{
+	uint16_t theRegisterValue=0;
+	INA226_ReadRegister(&this->Config,INA226_BUS_VOLTAGE, &theRegisterValue);
+	return INA226_BusVoltageFromRegister(theRegisterValue);
+}
+
+//----------------------------------------------------------------------------
+int32_t INA226_GetCurrent_uA(INA226* this)
+{
+	int16_t theRegisterValue=0; // signed register, result in mA
+	INA226_ReadRegister(&this->Config,INA226_CURRENT, (uint16_t*)&theRegisterValue);
+	return INA226_CurrentFromRegister(&this->Config, theRegisterValue);
+}
+//----------------------------------------------------------------------------
+int32_t INA226_GetPower_uW(INA226* this)
+{
+	uint16_t theRegisterValue=0;
+	INA226_ReadRegister(&this->Config,INA226_POWER, &theRegisterValue);
+	return INA226_PowerFromRegister(&this->Config, theRegisterValue);
+}
+//----------------------------------------------------------------------------
+//Builds the list of registers to read for a selection of eMeasureSelect flags,
+//in register address order. Returns the number of registers.
+static uint8_t INA226_SelectionToRegisters(uint8_t aSelection, uint8_t* aRegisters)
+{
+	uint8_t theCount = 0;
+	if(aSelection & MeasureShuntVoltage)	aRegisters[theCount++] = INA226_SHUNT_VOLTAGE;
+	if(aSelection & MeasureBusVoltage)		aRegisters[theCount++] = INA226_BUS_VOLTAGE;
+	if(aSelection & MeasurePower)			aRegisters[theCount++] = INA226_POWER;
+	if(aSelection & MeasureCurrent)			aRegisters[theCount++] = INA226_CURRENT;
+	return theCount;
+}
+
+//Stores a measurement register value to the matching field of Raw
+static void INA226_StoreRaw(INA226* this, uint8_t aRegister, uint16_t aValue)
+{
+	switch(aRegister){
+	case INA226_SHUNT_VOLTAGE_REG:
+		this->Raw.ShuntVoltage = (int16_t)aValue;
+		break;
+	case INA226_BUS_VOLTAGE_REG:
+		this->Raw.BusVoltage = aValue;
+		break;
+	case INA226_POWER_REG:
+		this->Raw.Power = aValue;
+		break;
+	case INA226_CURRENT_REG:
+		this->Raw.Current = (int16_t)aValue;
+		break;
+	default:
+		break;
+	}
+}
+
+//Converts a measurement register value and stores it to the matching field of Result
+static void INA226_StoreResult(INA226* this, uint8_t aRegister, uint16_t aValue)
+{
+	switch(aRegister){
+	case INA226_SHUNT_VOLTAGE_REG:
+		this->Result.ShuntVoltage_uV = INA226_ShuntVoltageFromRegister((int16_t)aValue);
+		break;
+	case INA226_BUS_VOLTAGE_REG:
+		this->Result.BusVoltage_uV = INA226_BusVoltageFromRegister(aValue);
+		break;
+	case INA226_POWER_REG:
+		this->Result.Power_uW = INA226_PowerFromRegister(&this->Config, aValue);
+		break;
+	case INA226_CURRENT_REG:
+		this->Result.Current_uA = INA226_CurrentFromRegister(&this->Config, (int16_t)aValue);
+		break;
+	default:
+		break;
+	}
+}
+//----------------------------------------------------------------------------
+status INA226_ReadRegisters(INA226_config* this, const uint8_t* aRegisters, uint16_t* aValues_p, uint8_t aCount)
+{
+	for(uint8_t i = 0; i < aCount; i++){
+		CALL_FN( INA226_ReadRegister(this, aRegisters[i], &aValues_p[i]) );
+	}
+	return OK;
+}
+//----------------------------------------------------------------------------
+//Clock time shifted by aOffset_us (e.g. back to the middle of the conversion window), 0 without clock
+static uint32_t INA226_Timestamp(INA226* this, int32_t aOffset_us)
+{
+	if(this->Acquisition.mClock == NULL){
+		return 0;
+	}
+	return this->Acquisition.mClock() + (uint32_t)aOffset_us;
+}
+//----------------------------------------------------------------------------
+status INA226_Measure(INA226* this, uint8_t aSelection)
+{
+	uint8_t  theRegisters[INA226_ASYNC_MAX_STEPS];
+	uint16_t theValues[INA226_ASYNC_MAX_STEPS];
+	uint8_t  theCount = INA226_SelectionToRegisters(aSelection, theRegisters);
+	if(theCount == 0){
+		return BAD_PARAMETER;
+	}
+
+	//The latest result finished on average half a period ago, its conversion window started one period before that
+	uint32_t theTimestamp = INA226_Timestamp(this, -(int32_t)INA226_GetConversionPeriod_us(&this->Config));
+	//Read everything first so Result is only touched if all reads succeeded
+	CALL_FN( INA226_ReadRegisters(&this->Config, theRegisters, theValues, theCount) );
+	for(uint8_t i = 0; i < theCount; i++){
+		INA226_StoreRaw(this, theRegisters[i], theValues[i]);
+		INA226_StoreResult(this, theRegisters[i], theValues[i]);
+	}
+	this->Result.Timestamp = theTimestamp;
+	return OK;
 }
+//----------------------------------------------------------------------------
+status INA226_MeasureRaw(INA226* this, uint8_t aSelection, INA226_raw* aRaw_p)
+{
+	uint8_t  theRegisters[INA226_ASYNC_MAX_STEPS];
+	uint16_t theValues[INA226_ASYNC_MAX_STEPS];
+	uint8_t  theCount = INA226_SelectionToRegisters(aSelection, theRegisters);
+	if(theCount == 0){
+		return BAD_PARAMETER;
+	}
 
+	CALL_FN( INA226_ReadRegisters(&this->Config, theRegisters, theValues, theCount) );
+	for(uint8_t i = 0; i < theCount; i++){
+		INA226_StoreRaw(this, theRegisters[i], theValues[i]);
+	}
+	if(aRaw_p != NULL){
+		*aRaw_p = this->Raw;
+	}
+	return OK;
+}
 //----------------------------------------------------------------------------
-status INA226_Init(INA226* this, void* i2c_device, uint8_t aI2C_Address, double aShuntResistor_Ohms, double aMaxCurrent_Amps)
+void INA226_ConvertRawBatch(const INA226_config* this, const INA226_raw* aRaw, INA226_result* aResult_p, uint32_t aCount)
 {
-	INA226_Constructor(&this->Config, i2c_device, aI2C_Address);
+	//Scale factors loaded once, the loop has no calls and no branches so the compiler can unroll/vectorise it
+	const int32_t theCurrentLSB = this->mCurrentMicroAmpsPerBit;
+	const int32_t thePowerLSB = this->mPowerMicroWattPerBit;
+	for(uint32_t i = 0; i < aCount; i++){
+		int32_t theShunt = aRaw[i].ShuntVoltage;
+		aResult_p[i].ShuntVoltage_uV = (theShunt>>1) + (theShunt<<1);
+		aResult_p[i].BusVoltage_uV = (int32_t)aRaw[i].BusVoltage * INA226_BUS_VOLTAGE_LSB;
+		aResult_p[i].Current_uA = (int32_t)aRaw[i].Current * theCurrentLSB;
+		aResult_p[i].Power_uW = (int32_t)aRaw[i].Power * thePowerLSB;
+	}
+}
+//----------------------------------------------------------------------------
+status INA226_MeasureAll(INA226* this){
+	return INA226_Measure(this, MeasureEverything);
+}
+//----------------------------------------------------------------------------
+//Asynchronous acquisition.
+//The sequence of registers is stored in this->Async. Every step starts one combined
+//pointer write + read (repeated START) and returns, the next step is started from
+//INA226_AsyncTransferComplete which the application calls from its I2C/DMA interrupt.
+//If the transport has no ReadRegister_Async, a step is split into a pointer write and
+//a read, each with its own completion.
 
-	//Check if there's a device (any I2C device) at the specified address.
-	CALL_FN( INA226_CheckI2cAddress(&this->Config, aI2C_Address) );
+enum {AsyncPhasePointer = 0, AsyncPhaseData = 1, AsyncPhaseWrite = 2};
 
-	//Good so far, check that it's an INA226 device at the specified address.
-	uint16_t theINA226_ID;
-	CALL_FN( INA226_ReadRegister(&this->Config,INA226_MANUFACTURER_ID, &theINA226_ID) );
-	if(theINA226_ID != INA226_MANUFACTURER_ID_K){
-		return INA226_TI_ID_MISMATCH; //Expected to find TI manufacturer ID
+static status INA226_AsyncStartStep(INA226* this)
+{
+	int theResult;
+	uint8_t theRegister = this->Async.mRegisters[this->Async.mIndex];
+	if(this->Async.mWrites & (1u << this->Async.mIndex)){
+		if(this->Config.mTransport->Transmit_Async == NULL){
+			return FAIL;
+		}
+		uint16_t theValue = this->Async.mValues[this->Async.mIndex];
+		this->Async.mPhase = AsyncPhaseWrite;
+		this->Async.mBuffer[0] = theRegister;
+		this->Async.mBuffer[1] = (uint8_t)(theValue >> 8);
+		this->Async.mBuffer[2] = (uint8_t)(theValue & 0xFF);
+		theResult = INA226_BusTransmitAsync(&this->Config, this->Async.mBuffer, 3);
+	}else if(INA226_PointerIsLatched(&this->Config, theRegister) && this->Config.mTransport->Receive_Async != NULL){
+		this->Async.mPhase = AsyncPhaseData;
+		theResult = INA226_BusReceiveAsync(&this->Config, this->Async.mBuffer, 2);
+	}else if(this->Config.mTransport->ReadRegister_Async != NULL){
+		this->Async.mPhase = AsyncPhaseData;
+		theResult = INA226_BusReadRegisterAsync(&this->Config, theRegister, this->Async.mBuffer, 2);
+	}else{
+		this->Async.mPhase = AsyncPhasePointer;
+		theResult = INA226_BusTransmitAsync(&this->Config, &this->Async.mRegisters[this->Async.mIndex], 1);
 	}
-	CALL_FN( INA226_ReadRegister(&this->Config,INA226_DIE_ID, &theINA226_ID) );
-	if( theINA226_ID != INA226_DIE_ID_K){
-		return  INA226_DIE_ID_MISMATCH; //Expected to find INA226 device ID
+	if (theResult != 0) { //Return 0 is OK
+		this->Config.mRegisterPointerValid = false;
+		return FAIL;
 	}
+	return OK;
+}
 
-	
-
-	//Reset the INA226 device
-	CALL_FN( INA226_WriteRegister(&this->Config,INA226_CONFIG, cResetCommand) );
+static void INA226_AcquisitionResume(INA226* this, bool aRetryFailed);
 
-	//Now set our own default configuration (you can redefine this constant in the header, as needed)
-	CALL_FN( INA226_WriteRegister(&this->Config,INA226_CONFIG, INA226_CONFIG_DEFAULT) );
+static void INA226_AsyncFinish(INA226* this, status aStatus)
+{
+	if(aStatus != OK){
+		this->Config.mRegisterPointerValid = false;
+	}
+	INA226_AccountAccess(&this->Config, aStatus);
+	if(aStatus == OK){
+		for(uint8_t i = 0; i < this->Async.mCount; i++){
+			INA226_StoreRaw(this, this->Async.mRegisters[i], this->Async.mValues[i]);
+			if(this->Async.mConvert){
+				INA226_StoreResult(this, this->Async.mRegisters[i], this->Async.mValues[i]);
+			}
+		}
+		if(this->Async.mConvert){
+			this->Result.Timestamp = this->Async.mTimestamp;
+		}
+	}
+	//Go idle before calling back so the callback can start the next acquisition
+	this->Async.mState = AsyncIdle;
+	if(this->Async.mOnComplete != NULL){
+		this->Async.mOnComplete(this, aStatus);
+	}
+	//An ALERT edge that came while this sequence ran is serviced now, the pin stays asserted until then
+	INA226_AcquisitionResume(this, false);
+}
 
-	//Read back the configuration register and check that it matches
-	CALL_FN( INA226_ReadRegister(&this->Config,INA226_CONFIG, &(this->Config.mConfigRegister)) );
-	if(this->Config.mConfigRegister != INA226_CONFIG_DEFAULT){
-		return CONFIG_ERROR;
+//Starts the register sequence already stored in this->Async.mRegisters (and mValues for the writes)
+static status INA226_AsyncStart(INA226* this, uint8_t aCount, uint8_t aWrites, bool aConvert, INA226_AsyncCallback aOnComplete)
+{
+	if(this->Config.mDegraded && !this->Async.mProbing){
+		this->Async.mState = AsyncIdle;
+		return INA226_DEGRADED;
 	}
+	this->Async.mOnComplete = aOnComplete;
+	this->Async.mWrites = aWrites;
+	this->Async.mConvert = aConvert;
+	this->Async.mCount = aCount;
+	this->Async.mIndex = 0;
+
+	status s = INA226_AsyncStartStep(this);
+	if(s != OK){
+		this->Async.mState = AsyncIdle;
+		INA226_AccountAccess(&this->Config, s);
+	}
+	return s;
+}
 
-	//Finally, set up the calibration register - this will also calculate the scaling
-	//factors that we must apply to the current and power measurements that we read from
-	//the INA226 device.
-	CALL_FN( INA226_setupCalibration(&this->Config, aShuntResistor_Ohms, aMaxCurrent_Amps) );
+static status INA226_MeasureAsyncCommon(INA226* this, uint8_t aSelection, bool aConvert, INA226_AsyncCallback aOnComplete)
+{
+	if(this->Async.mState != AsyncIdle){
+		return INA226_BUSY;
+	}
+	uint8_t theCount = INA226_SelectionToRegisters(aSelection, this->Async.mRegisters);
+	if(theCount == 0){
+		return BAD_PARAMETER;
+	}
+	this->Async.mState = AsyncBusy;
+	this->Async.mTimestamp = INA226_Timestamp(this, -(int32_t)INA226_GetConversionPeriod_us(&this->Config));
+	return INA226_AsyncStart(this, theCount, 0, aConvert, aOnComplete);
+}
 
-	this->Config.mInitialized = true;
-	return OK;
+status INA226_MeasureAsync(INA226* this, uint8_t aSelection, INA226_AsyncCallback aOnComplete)
+{
+	return INA226_MeasureAsyncCommon(this, aSelection, true, aOnComplete);
 }
 //----------------------------------------------------------------------------
-
-status INA226_setupCalibration(INA226_config* this, double aShuntResistor_Ohms, double aMaxCurrent_Amps)
+status INA226_MeasureRawAsync(INA226* this, uint8_t aSelection, INA226_AsyncCallback aOnComplete)
 {
-	// Calculate a value for Current_LSB that gives us the best resolution
-	// for current measurements.  The INA266 current register is 16-bit
-	// signed, max positive value is 2^15 -1 = 32767
-	// If we can be sure that the current won't be more than aMaxCurrent_Amps then
-	// we can calculate the Amps per bit as aMaxCurrent_Amps/32767 (rounded up to
-	// to the nearest integer).
-	// The value 0.00512 in the calculations below comes from the INA226 spec which
-	// provides a definition of the formula that's used to calculate the calibration value.
-
-	double theCurrentLSB = ceil( ( aMaxCurrent_Amps * 1000000.0) / (double)32767.0);
-	double theCal = (double)0.00521 /  (aShuntResistor_Ohms * (theCurrentLSB/1000000.0));
-
-	this->mCurrentMicroAmpsPerBit = ((int32_t)theCurrentLSB);
-	this->mCalibrationValue = (uint16_t)theCal;
-	this->mPowerMicroWattPerBit = this->mCurrentMicroAmpsPerBit * INA226_POWER_LSB_FACTOR;
-
-	return INA226_WriteRegister(this,INA226_CALIBRATION, this->mCalibrationValue);
+	return INA226_MeasureAsyncCommon(this, aSelection, false, aOnComplete);
 }
 //----------------------------------------------------------------------------
-//Check if a device exists at the specified I2C address
-
-status INA226_CheckI2cAddress(INA226_config* this, uint8_t aI2C_Address)
+status INA226_MeasureAllAsync(INA226* this, INA226_AsyncCallback aOnComplete)
 {
-	if(Check_device(this, (uint16_t)aI2C_Address, 10) != 0){ //Return 0 is OK
-		return INVALID_I2C_ADDRESS;
+	return INA226_MeasureAsync(this, MeasureEverything, aOnComplete);
+}
+//----------------------------------------------------------------------------
+status INA226_ReadRegisterAsync(INA226* this, uint8_t aRegister, INA226_AsyncCallback aOnComplete)
+{
+	if(this->Async.mState != AsyncIdle){
+		return INA226_BUSY;
+	}
+	this->Async.mState = AsyncBusy;
+	this->Async.mRegisters[0] = aRegister;
+	return INA226_AsyncStart(this, 1, 0, false, aOnComplete);
+}
+//----------------------------------------------------------------------------
+status INA226_WriteRegistersAsync(INA226* this, const uint8_t* aRegisters, const uint16_t* aValues, uint8_t aCount, INA226_AsyncCallback aOnComplete)
+{
+	if(aCount == 0 || aCount > INA226_ASYNC_MAX_STEPS){
+		return BAD_PARAMETER;
+	}
+	if(this->Async.mState != AsyncIdle){
+		return INA226_BUSY;
+	}
+	this->Async.mState = AsyncBusy;
+	for(uint8_t i = 0; i < aCount; i++){
+		this->Async.mRegisters[i] = aRegisters[i];
+		this->Async.mValues[i] = aValues[i];
+	}
+	return INA226_AsyncStart(this, aCount, (uint8_t)((1u << aCount) - 1), false, aOnComplete);
+}
+//----------------------------------------------------------------------------
+static void INA226_ReprobeDone(INA226* this, status aStatus)
+{
+	this->Async.mProbing = false;
+	if(aStatus == OK){
+		this->Config.mFailures = 0;
+		this->Config.mDegraded = false;
 	}else{
-		return OK;
+		//Not (completely) restored: the next reprobe compares with the same values
+		INA226_RestoreShadows(&this->Config, this->Async.mSaved);
+	}
+	if(this->Async.mOnProbed != NULL){
+		this->Async.mOnProbed(this, aStatus);
 	}
 }
 
-//----------------------------------------------------------------------------
+static void INA226_ReprobeRead(INA226* this, status aStatus)
+{
+	//The read went through the shadow, put back the value we expect the device to have
+	this->Config.mCalibrationValue = this->Async.mSaved[3];
+	if(aStatus == OK && this->Async.mValues[0] != this->Async.mSaved[3]){
+		//The device was reset, restore the settings (the engine is idle again here)
+		aStatus = INA226_WriteRegistersAsync(this, caRestoredRegisters, this->Async.mSaved, 4, INA226_ReprobeDone);
+		if(aStatus == OK){
+			return;
+		}
+	}
+	INA226_ReprobeDone(this, aStatus);
+}
 
-status INA226_ReadRegister(INA226_config* this, uint8_t aRegister, uint16_t* aValue_p)
+status INA226_ReprobeAsync(INA226* this, INA226_AsyncCallback aOnComplete)
 {
-	*aValue_p = 0;
+	if(!this->Config.mInitialized){
+		return NOT_INITIALIZED;
+	}
+	if(this->Async.mState != AsyncIdle){
+		return INA226_BUSY;
+	}
+	//The read updates the shadows, keep the values we expect the device to have
+	INA226_SaveShadows(&this->Config, this->Async.mSaved);
+	this->Async.mOnProbed = aOnComplete;
+	this->Async.mProbing = true;
+	status s = INA226_ReadRegisterAsync(this, INA226_CALIBRATION, INA226_ReprobeRead);
+	if(s != OK){
+		this->Async.mProbing = false;
+	}
+	return s;
+}
+//----------------------------------------------------------------------------
+bool INA226_AsyncIsBusy(INA226* this)
+{
+	return this->Async.mState != AsyncIdle;
+}
+//----------------------------------------------------------------------------
+void INA226_AsyncTransferComplete(INA226* this)
+{
+	if(this->Async.mState == AsyncIdle){
+		return; //Not our transfer
+	}
+	TRACE_ASYNC_END(&this->Config, 0);
+	if(this->Async.mPhase == AsyncPhasePointer){
+		//Pointer is set, now read the register content
+		this->Async.mPhase = AsyncPhaseData;
+		if(INA226_BusReceiveAsync(&this->Config, this->Async.mBuffer, 2) != 0){
+			INA226_AsyncFinish(this, FAIL);
+		}
+		return;
+	}
+	if(this->Async.mPhase != AsyncPhaseWrite){
+		this->Async.mValues[this->Async.mIndex] = (uint16_t)this->Async.mBuffer[0]<<8 | this->Async.mBuffer[1];
+	}
+	INA226_UpdatePointer(&this->Config, this->Async.mRegisters[this->Async.mIndex], true);
+	INA226_UpdateShadow(&this->Config, this->Async.mRegisters[this->Async.mIndex], this->Async.mValues[this->Async.mIndex]);
+	this->Async.mIndex++;
+	if(this->Async.mIndex < this->Async.mCount){
+		if(INA226_AsyncStartStep(this) != OK){
+			INA226_AsyncFinish(this, FAIL);
+		}
+		return;
+	}
+	INA226_AsyncFinish(this, OK);
+}
+//----------------------------------------------------------------------------
+void INA226_AsyncTransferError(INA226* this)
+{
+	if(this->Async.mState == AsyncIdle){
+		return;
+	}
+	TRACE_ASYNC_END(&this->Config, -1);
+	INA226_AsyncFinish(this, I2C_TRANSMISSION_ERROR);
+}
+//----------------------------------------------------------------------------
+//Conversion-ready acquisition
 
-	uint8_t buffer[2];
-	if (Transmit(this, &aRegister, 1)
-			!= 0) {							//Return 0 is OK
-		return FAIL;
+static void INA226_AcquisitionComplete(INA226* this, status aStatus)
+{
+	if(aStatus != OK){
+		//MASK_ENABLE may not have been read, so the pin may still be asserted: read again
+		this->Acquisition.mErrors++;
+		this->Acquisition.mAlertFailures++;
+		this->Acquisition.mPendingTimestamp = this->Acquisition.mAlertTimestamp;
+		this->Acquisition.mAlertPending = true;
+		if(this->Acquisition.mOnSample != NULL){
+			this->Acquisition.mOnSample(this, aStatus);
+		}
+		return;
 	}
-	if (Receive(this, buffer, 2) != 0) {	//Return 0 is OK
-		return FAIL;
+	this->Acquisition.mAlertFailures = 0;
+	//No conversion ready flag: read without a new conversion (INA226_AcquisitionPoll), not a sample
+	bool theNewConversion = (this->Async.mValues[0] & ConversionReadyFlag) != 0;
+	if(theNewConversion){
+		this->Acquisition.mSamples++;
+		if(this->Acquisition.mEnergy != NULL){
+			//The values of this sample stand in for the conversions lost since the last one
+			uint32_t theLost = this->Acquisition.mOverruns + this->Acquisition.mErrors;
+			INA226_Energy_Add(this->Acquisition.mEnergy, &this->Raw, 1 + (theLost - this->Acquisition.mLostAtLastSample));
+			this->Acquisition.mLostAtLastSample = theLost;
+		}
+	}
+	if(this->Async.mWrites != 0){
+		//The queued configuration is written (last step), following samples use its conversion period
+		if(this->Acquisition.mPendingConfig == this->Async.mValues[this->Async.mCount - 1]){
+			this->Acquisition.mConfigPending = false;
+		}
+		if(this->Acquisition.mEnergy != NULL){
+			INA226_Energy_Sync(this->Acquisition.mEnergy, &this->Config);
+		}
+	}
+	if(!theNewConversion){
+		return;
+	}
+	if(this->Acquisition.mRing != NULL){
+		INA226_sample theSample;
+		theSample.Timestamp = this->Acquisition.mAlertTimestamp;
+		theSample.Raw = this->Raw;
+		if(!INA226_Ring_Push(this->Acquisition.mRing, &theSample)){
+			this->Acquisition.mDropped++;
+		}
+	}
+	if(this->Acquisition.mOnSample != NULL){
+		this->Acquisition.mOnSample(this, aStatus);
 	}
-	*aValue_p = buffer[0];
-	*aValue_p = *aValue_p<<8 | buffer[1];
-	return OK;
 }
 
+status INA226_StartConversionReadyAcquisition(INA226* this, uint8_t aSelection, struct INA226_ring* aRing, INA226_AsyncCallback aOnSample)
+{
+	uint8_t theRegisters[INA226_ASYNC_MAX_STEPS];
+	if(INA226_SelectionToRegisters(aSelection, theRegisters) == 0){
+		return BAD_PARAMETER;
+	}
+	this->Acquisition.mRunning = false;
+	this->Acquisition.mSelection = aSelection;
+	this->Acquisition.mRing = aRing;
+	this->Acquisition.mOnSample = aOnSample;
+	this->Acquisition.mSamples = 0;
+	this->Acquisition.mOverruns = 0;
+	this->Acquisition.mDropped = 0;
+	this->Acquisition.mErrors = 0;
+	this->Acquisition.mLostAtLastSample = 0;
+	this->Acquisition.mConfigPending = false;
+	this->Acquisition.mAlertPending = false;
+	this->Acquisition.mAlertFailures = 0;
+
+	CALL_FN( INA226_ConfigureAlertPinTrigger(&this->Config, ConversionReady, 0, false) );
+	this->Acquisition.mRunning = true;
+	return OK;
+}
 //----------------------------------------------------------------------------
-status INA226_WriteRegister(INA226_config* this, uint8_t aRegister, uint16_t aValue)
+status INA226_SetClock(INA226* this, INA226_ClockFn aClock)
 {
-	uint8_t buffer[3];
-	buffer[0] = aRegister;
-	buffer[1] = (uint8_t) ((aValue >> 8) & 0xFF);
-	buffer[2] = (uint8_t) (aValue & 0xFF);
-	if (Transmit(this, buffer, 3)
-			!= 0) {				//Return 0 is OK
-		return FAIL;
+	this->Acquisition.mClock = aClock;
+	return OK;
+}
+//----------------------------------------------------------------------------
+status INA226_SetEnergyCounter(INA226* this, struct INA226_energy* aCounter)
+{
+	this->Acquisition.mLostAtLastSample = this->Acquisition.mOverruns + this->Acquisition.mErrors;
+	this->Acquisition.mEnergy = aCounter;
+	return OK;
+}
+//----------------------------------------------------------------------------
+status INA226_QueueConfigWrite(INA226* this, uint16_t aConfigRegister)
+{
+	if(!this->Config.mInitialized){
+		return NOT_INITIALIZED;
 	}
+	if(!this->Acquisition.mRunning){
+		if(this->Async.mState != AsyncIdle){
+			return INA226_BUSY;
+		}
+		return INA226_WriteRegister(&this->Config, INA226_CONFIG, aConfigRegister);
+	}
+	this->Acquisition.mPendingConfig = aConfigRegister;
+	INA226_MEMORY_BARRIER();
+	this->Acquisition.mConfigPending = true;
 	return OK;
 }
 //----------------------------------------------------------------------------
-int32_t INA226_GetShuntVoltage_uV(INA226* this)
+status INA226_StopConversionReadyAcquisition(INA226* this)
 {
-	//The value retrieved from the INA226 for the shunt voltage
-	//needs to be multiplied by 2.5 to yield the value in microvolts.
-	//As I don't want to use floating point multiplication I will take the value
-	//divide it by 2 (shift right) and add that to 2 times the original value
-	//(shift left).
-	int16_t theRegisterValue=0;
-	int32_t theResult;
-	INA226_ReadRegister(&this->Config,INA226_SHUNT_VOLTAGE, (uint16_t*)&theRegisterValue);
-	theResult = (int32_t)theRegisterValue>>1;
-	theResult+= (int32_t)theRegisterValue<<1;
-	return theResult;
+	this->Acquisition.mRunning = false;
+	return INA226_ConfigureAlertPinTrigger(&this->Config, ClearTriggers, 0, false);
 }
 //----------------------------------------------------------------------------
-int32_t INA226_GetBusVoltage_uV(INA226* this)
+//Starts the read sequence of a conversion, the engine is idle
+static void INA226_AcquisitionRead(INA226* this, uint32_t aTimestamp)
 {
-	uint16_t theRegisterValue=0;
-	INA226_ReadRegister(&this->Config,INA226_BUS_VOLTAGE, &theRegisterValue);
-	return (int32_t)theRegisterValue * INA226_BUS_VOLTAGE_LSB;
+	this->Async.mState = AsyncBusy;
+	this->Acquisition.mAlertPending = false;
+	this->Acquisition.mAlertTimestamp = aTimestamp;
+	//Reading MASK_ENABLE first clears the conversion ready flag and releases the ALERT pin,
+	//so the next conversion can signal again while we read the results.
+	this->Async.mRegisters[0] = INA226_MASK_ENABLE;
+	uint8_t theCount = 1 + INA226_SelectionToRegisters(this->Acquisition.mSelection, &this->Async.mRegisters[1]);
+	uint8_t theWrites = 0;
+	if(this->Acquisition.mConfigPending){
+		this->Async.mRegisters[theCount] = INA226_CONFIG;
+		this->Async.mValues[theCount] = this->Acquisition.mPendingConfig;
+		theWrites = 1u << theCount;
+		theCount++;
+	}
+	if(INA226_AsyncStart(this, theCount, theWrites, false, INA226_AcquisitionComplete) != OK){
+		//Nothing completes now, INA226_AcquisitionPoll retries
+		this->Acquisition.mErrors++;
+		this->Acquisition.mAlertFailures++;
+		this->Acquisition.mPendingTimestamp = aTimestamp;
+		this->Acquisition.mAlertPending = true;
+	}
 }
 
+//Reads the conversion of an ALERT edge that found the bus busy or whose read failed.
+//Failed reads are retried right away cAlertRetries times in a row, then only by INA226_AcquisitionPoll.
+static void INA226_AcquisitionResume(INA226* this, bool aRetryFailed)
+{
+	if(!this->Acquisition.mRunning || !this->Acquisition.mAlertPending || this->Async.mState != AsyncIdle){
+		return;
+	}
+	if(!aRetryFailed && this->Acquisition.mAlertFailures >= cAlertRetries){
+		return;
+	}
+	INA226_AcquisitionRead(this, this->Acquisition.mPendingTimestamp);
+}
 //----------------------------------------------------------------------------
-int32_t INA226_GetCurrent_uA(INA226* this)
+void INA226_AlertPinISR(INA226* this)
 {
-	int16_t theRegisterValue=0; // signed register, result in mA
-	INA226_ReadRegister(&this->Config,INA226_CURRENT, (uint16_t*)&theRegisterValue);
-	return (int32_t)theRegisterValue * this->Config.mCurrentMicroAmpsPerBit;
+	if(this->Acquisition.mTriggerState == TriggerWaiting){
+		INA226_TriggerTimerElapsed(this);
+		return;
+	}
+	if(!this->Acquisition.mRunning){
+		return;
+	}
+	//Timestamp as close as possible to the end of the conversion, moved back to the middle of its window
+	uint32_t theTimestamp = INA226_Timestamp(this, -(int32_t)(INA226_GetConversionPeriod_us(&this->Config) / 2));
+	if(this->Async.mState != AsyncIdle){
+		//The pin stays asserted (no more edges) until MASK_ENABLE is read: at the end of the running sequence
+		this->Acquisition.mOverruns++;
+		this->Acquisition.mPendingTimestamp = theTimestamp;
+		this->Acquisition.mAlertPending = true;
+		return;
+	}
+	INA226_AcquisitionRead(this, theTimestamp);
 }
 //----------------------------------------------------------------------------
-int32_t INA226_GetPower_uW(INA226* this)
+void INA226_AcquisitionPoll(INA226* this)
 {
-	uint16_t theRegisterValue=0;
-	int32_t theReturnValue;
-	INA226_ReadRegister(&this->Config,INA226_POWER, &theRegisterValue);
-	theReturnValue = (int32_t)theRegisterValue * this->Config.mPowerMicroWattPerBit;
-	return theReturnValue;
+	INA226_AcquisitionResume(this, true);
 }
 //----------------------------------------------------------------------------
-status INA226_MeasureAll(INA226* this){
-	int r=0;
-	r |= this->Result.ShuntVoltage_uV	=		INA226_GetShuntVoltage_uV(this);
-	r |= this->Result.BusVoltage_uV		=		INA226_GetBusVoltage_uV(this);
-	r |= this->Result.Current_uA		=		INA226_GetCurrent_uA(this);
-	r |= this->Result.Power_uW			=		INA226_GetPower_uW(this);
-	return r;
+//Single-shot (triggered) conversion
+
+static status INA226_TriggerConfig(INA226* this, enum eOperatingMode aMode, uint8_t aSelection, uint16_t* aConfig_p)
+{
+	if(!this->Config.mInitialized){
+		return NOT_INITIALIZED;
+	}
+	if(aMode != ShuntVoltageTriggered && aMode != BusVoltageTriggered && aMode != ShuntAndBusTriggered){
+		return BAD_PARAMETER;
+	}
+	uint8_t theRegisters[INA226_ASYNC_MAX_STEPS];
+	if(INA226_SelectionToRegisters(aSelection, theRegisters) == 0){
+		return BAD_PARAMETER;
+	}
+	*aConfig_p = (this->Config.mConfigRegister & ~cOperatingModeMask) | (uint16_t)aMode;
+	return OK;
+}
+
+status INA226_TriggerAndRead(INA226* this, enum eOperatingMode aMode, uint8_t aSelection, INA226_DelayFn aDelay)
+{
+	uint16_t theConfig;
+	CALL_FN( INA226_TriggerConfig(this, aMode, aSelection, &theConfig) );
+	uint32_t theConversionTime = INA226_ConfigConversionPeriod_us(theConfig);
+
+	//Writing the configuration register starts the conversion and clears the conversion ready flag
+	CALL_FN( INA226_WriteRegister(&this->Config, INA226_CONFIG, theConfig) );
+	uint32_t theTimestamp = INA226_Timestamp(this, (int32_t)(theConversionTime / 2));
+
+	//Poll every 1/16 of the conversion time up to twice the conversion time,
+	//without delay function assume a poll takes at least 25us
+	uint32_t theMaxPolls = aDelay != NULL ? cTriggerPollsPerConversion : theConversionTime / 25 + cTriggerPollsPerConversion;
+	if(aDelay != NULL){
+		aDelay(theConversionTime);
+	}
+	for(uint32_t i = 0; ; i++){
+		uint16_t theMaskEnable;
+		CALL_FN( INA226_ReadRegister(&this->Config, INA226_MASK_ENABLE, &theMaskEnable) );
+		if(theMaskEnable & ConversionReadyFlag){
+			break;
+		}
+		if(i >= theMaxPolls){
+			return INA226_CONVERSION_TIMEOUT;
+		}
+		if(aDelay != NULL){
+			aDelay(theConversionTime / cTriggerPollsPerConversion + 1);
+		}
+	}
+	CALL_FN( INA226_Measure(this, aSelection) );
+	this->Result.Timestamp = theTimestamp;
+	return OK;
+}
+//----------------------------------------------------------------------------
+static void INA226_TriggerDone(INA226* this, status aStatus)
+{
+	this->Acquisition.mTriggerState = TriggerIdle;
+	if(this->Acquisition.mOnTrigger != NULL){
+		this->Acquisition.mOnTrigger(this, aStatus);
+	}
+}
+
+static void INA226_TriggerChecked(INA226* this, status aStatus)
+{
+	if(aStatus == OK && !(this->Async.mValues[0] & ConversionReadyFlag)){
+		//Too early, the caller tries again later
+		this->Acquisition.mTriggerState = TriggerWaiting;
+		aStatus = INA226_BUSY;
+	}else if(aStatus == OK){
+		//Engine is idle again here, read the results
+		this->Async.mState = AsyncBusy;
+		uint8_t theCount = INA226_SelectionToRegisters(this->Acquisition.mTriggerSelection, this->Async.mRegisters);
+		aStatus = INA226_AsyncStart(this, theCount, 0, true, INA226_TriggerDone);
+		if(aStatus == OK){
+			return;
+		}
+		this->Acquisition.mTriggerState = TriggerIdle;
+	}else{
+		this->Acquisition.mTriggerState = TriggerIdle;
+	}
+	if(this->Acquisition.mOnTrigger != NULL){
+		this->Acquisition.mOnTrigger(this, aStatus);
+	}
 }
+
+static void INA226_TriggerWritten(INA226* this, status aStatus)
+{
+	if(aStatus == OK){
+		//The conversion started with the end of the write, kept for the final read of the results
+		this->Async.mTimestamp = INA226_Timestamp(this, (int32_t)(INA226_GetConversionPeriod_us(&this->Config) / 2));
+		this->Acquisition.mTriggerState = TriggerWaiting;
+		return;
+	}
+	INA226_TriggerDone(this, aStatus);
+}
+
+status INA226_TriggerAndReadAsync(INA226* this, enum eOperatingMode aMode, uint8_t aSelection, INA226_AsyncCallback aOnComplete, uint32_t* aReadyIn_us_p)
+{
+	uint16_t theConfig;
+	CALL_FN( INA226_TriggerConfig(this, aMode, aSelection, &theConfig) );
+	if(this->Async.mState != AsyncIdle || this->Acquisition.mTriggerState != TriggerIdle || this->Acquisition.mRunning){
+		return INA226_BUSY;
+	}
+	if(aReadyIn_us_p != NULL){
+		uint32_t theConversionTime = INA226_ConfigConversionPeriod_us(theConfig);
+		*aReadyIn_us_p = theConversionTime + theConversionTime / 10;
+	}
+	this->Acquisition.mTriggerSelection = aSelection;
+	this->Acquisition.mOnTrigger = aOnComplete;
+	this->Acquisition.mTriggerState = TriggerWriting;
+	this->Async.mState = AsyncBusy;
+	this->Async.mRegisters[0] = INA226_CONFIG;
+	this->Async.mValues[0] = theConfig;
+	status s = INA226_AsyncStart(this, 1, 0x01, false, INA226_TriggerWritten);
+	if(s != OK){
+		this->Acquisition.mTriggerState = TriggerIdle;
+	}
+	return s;
+}
+//----------------------------------------------------------------------------
+void INA226_TriggerTimerElapsed(INA226* this)
+{
+	if(this->Acquisition.mTriggerState != TriggerWaiting || this->Async.mState != AsyncIdle){
+		return;
+	}
+	this->Acquisition.mTriggerState = TriggerReading;
+	this->Async.mState = AsyncBusy;
+	//Reading MASK_ENABLE also releases the ALERT pin
+	this->Async.mRegisters[0] = INA226_MASK_ENABLE;
+	if(INA226_AsyncStart(this, 1, 0, false, INA226_TriggerChecked) != OK){
+		INA226_TriggerDone(this, FAIL);
+	}
+}
+//----------------------------------------------------------------------------
 status INA226_Hibernate(INA226_config* this)
 {
 	CHECK_INITIALIZED();
 	//Make a most recent copy of the configuration register, which also contains
 	//The operating mode (we need a copy of this for when we come out of sleep)
-	CALL_FN( INA226_ReadRegister(this,INA226_CONFIG, &(this->mConfigRegister)) );
+	CALL_FN( INA226_RefreshShadow(this,INA226_CONFIG) );
+	uint16_t theOperatingMode = this->mConfigRegister & cOperatingModeMask;
 
 	//Zero out the operating more, this will put the INA226 into shutdown
 	uint16_t theTempConfigValue = this->mConfigRegister & ~(cOperatingModeMask);
 
-	return INA226_WriteRegister(this,INA226_CONFIG, theTempConfigValue);
+	CALL_FN( INA226_WriteRegister(this,INA226_CONFIG, theTempConfigValue) );
+	if(theOperatingMode != 0){
+		this->mOperatingModeBeforeHibernate = theOperatingMode;
+	}
+	return OK;
 }
 //----------------------------------------------------------------------------
 status INA226_Wakeup(INA226_config* this)
 {
 	CHECK_INITIALIZED();
-	//Write most recent copy of the calibration register - which should restore
-	//the most operating mode that was active before hibernation.  Quick check to test if by
+	//Write most recent copy of the configuration register with the operating mode
+	//that was active before hibernation.  Quick check to test if by
 	//any chance the last operating mode was a hibernation and in that case set to 
 	//ShuntAndBusVoltageContinuous.
 	uint16_t theLastOperatingMode = this->mConfigRegister & cOperatingModeMask;
+	if(theLastOperatingMode == 0){
+		theLastOperatingMode = this->mOperatingModeBeforeHibernate;
+	}
 	if(theLastOperatingMode == Shutdown ||
 		theLastOperatingMode == 0){
-			this->mConfigRegister &= ~cOperatingModeMask;
-			this->mConfigRegister |= ShuntAndBusVoltageContinuous;
+			theLastOperatingMode = ShuntAndBusVoltageContinuous;
 	}
 
-	return INA226_WriteRegister(this,INA226_CONFIG, this->mConfigRegister);
+	uint16_t theConfig = (this->mConfigRegister & ~cOperatingModeMask) | theLastOperatingMode;
+	return INA226_WriteRegister(this,INA226_CONFIG, theConfig);
 }
 //----------------------------------------------------------------------------
 status INA226_SetOperatingMode(INA226_config* this, enum eOperatingMode aOpMode)
 {
 	CHECK_INITIALIZED();
-	CALL_FN( INA226_ReadRegister(this,INA226_CONFIG, &(this->mConfigRegister)) );
+	CALL_FN( INA226_RefreshShadow(this,INA226_CONFIG) );
 
 	//Zero out the existing mode then OR in the new mode
-	this->mConfigRegister  &= ~(cOperatingModeMask);
-	this->mConfigRegister  |= (uint16_t)aOpMode;
+	uint16_t theConfig = this->mConfigRegister & ~(cOperatingModeMask);
+	theConfig |= (uint16_t)aOpMode;
 
-	return INA226_WriteRegister(this,INA226_CONFIG, this->mConfigRegister);
+	return INA226_WriteRegister(this,INA226_CONFIG, theConfig);
 }
 //----------------------------------------------------------------------------
-status  INA226_ConfigureAlertPinTrigger(INA226_config* this, enum eAlertTrigger aAlertTrigger, int32_t aValue, bool aLatching)
+status INA226_EncodeAlertTrigger(const INA226_config* this, enum eAlertTrigger aAlertTrigger, int32_t aValue, bool aLatching,
+		uint16_t* aMaskEnable_p, uint16_t* aAlertLimit_p)
 {
-	uint16_t theMaskEnableRegister;
-
-	CHECK_INITIALIZED();
-	CALL_FN( INA226_ReadRegister(this,INA226_MASK_ENABLE, &theMaskEnableRegister) );
+	CHECK_INITIALIZED(); //the power limit is scaled with the calibration
+	uint16_t theMaskEnableRegister = this->mMaskEnableRegister;
 
 	//Clear the current configuration for the alert pin
 	theMaskEnableRegister &= ~ cAlertPinModeMask;
@@ -343,8 +1640,22 @@ status  INA226_ConfigureAlertPinTrigger(INA226_config* this, enum eAlertTrigger
 	}
 
 
+	*aMaskEnable_p = theMaskEnableRegister;
+	*aAlertLimit_p = (uint16_t)(int16_t)theAlertValue;
+	return OK;
+}
+//----------------------------------------------------------------------------
+status  INA226_ConfigureAlertPinTrigger(INA226_config* this, enum eAlertTrigger aAlertTrigger, int32_t aValue, bool aLatching)
+{
+	uint16_t theMaskEnableRegister;
+	uint16_t theAlertLimit;
+
+	CHECK_INITIALIZED();
+	CALL_FN( INA226_RefreshShadow(this,INA226_MASK_ENABLE) );
+	CALL_FN( INA226_EncodeAlertTrigger(this, aAlertTrigger, aValue, aLatching, &theMaskEnableRegister, &theAlertLimit) );
+
 	//before we set the new config for the alert pin, set the value that will trigger the alert
-	CALL_FN( INA226_WriteRegister(this,INA226_ALERT_LIMIT, (int16_t)theAlertValue) );
+	CALL_FN( INA226_WriteRegister(this,INA226_ALERT_LIMIT, theAlertLimit) );
 	//Now set the trigger mode.
 	return INA226_WriteRegister(this,INA226_MASK_ENABLE, theMaskEnableRegister);
 }
@@ -377,25 +1688,32 @@ status INA226_ResetAlertPin(INA226_config* this, enum  eAlertTriggerCause* aAler
 }
 //----------------------------------------------------------------------------
 status INA226_ConfigureVoltageConversionTime(INA226_config* this, int aIndexToConversionTimeTable)
+{
+	//Same conversion time for the bus and the shunt voltage
+	return INA226_ConfigureConversionTimes(this, aIndexToConversionTimeTable, aIndexToConversionTimeTable);
+}
+//----------------------------------------------------------------------------
+status INA226_ConfigureConversionTimes(INA226_config* this, int aBusIndex, int aShuntIndex)
 {
 	CHECK_INITIALIZED();
 
-	if(aIndexToConversionTimeTable < 0 || aIndexToConversionTimeTable > cMaxConvTimeTblIdx ){
+	if(aBusIndex < 0 || aBusIndex > cMaxConvTimeTblIdx ||
+		aShuntIndex < 0 || aShuntIndex > cMaxConvTimeTblIdx){
 		return BAD_PARAMETER;
 	}
 
 	//Read the configuration register
-	CALL_FN( INA226_ReadRegister(this,INA226_CONFIG, &(this->mConfigRegister)) );
+	CALL_FN( INA226_RefreshShadow(this,INA226_CONFIG) );
 	//Clear the current voltage sampling time settings
-	this->mConfigRegister &= ~(cBusVoltageConvTimeMask | cShuntVoltageConvTimeMask);
+	uint16_t theConfig = this->mConfigRegister & ~(cBusVoltageConvTimeMask | cShuntVoltageConvTimeMask);
 	//Set the new values
 	uint16_t theMergedBusAndShuntConvTimeIndicies = 
-		((uint16_t)aIndexToConversionTimeTable << cBusVoltConvTimeIdxShift) |
-		((uint16_t)aIndexToConversionTimeTable << cShuntVoltConvTimeIdxShift);
+		((uint16_t)aBusIndex << cBusVoltConvTimeIdxShift) |
+		((uint16_t)aShuntIndex << cShuntVoltConvTimeIdxShift);
 
-	this->mConfigRegister |= theMergedBusAndShuntConvTimeIndicies;
+	theConfig |= theMergedBusAndShuntConvTimeIndicies;
 
-	return INA226_WriteRegister(this,INA226_CONFIG, this->mConfigRegister);
+	return INA226_WriteRegister(this,INA226_CONFIG, theConfig);
 }
 //----------------------------------------------------------------------------
 status INA226_ConfigureNumSampleAveraging(INA226_config* this, int aIndexToSampleAverageTable)
@@ -407,13 +1725,70 @@ status INA226_ConfigureNumSampleAveraging(INA226_config* this, int aIndexToSampl
 	}
 
 	//Read the configuration register
-	CALL_FN( INA226_ReadRegister(this,INA226_CONFIG, &(this->mConfigRegister)) );
+	CALL_FN( INA226_RefreshShadow(this,INA226_CONFIG) );
 	//Clear the current averaging value
-	this->mConfigRegister &= ~cSampleAvgMask;
+	uint16_t theConfig = this->mConfigRegister & ~cSampleAvgMask;
 	//Set the new value
-	this->mConfigRegister |= (aIndexToSampleAverageTable<<cSampleAvgIdxShift);
+	theConfig |= (aIndexToSampleAverageTable<<cSampleAvgIdxShift);
+
+	return INA226_WriteRegister(this,INA226_CONFIG, theConfig);
+}
+//----------------------------------------------------------------------------
+status INA226_EncodeSettings(const INA226_settings* aSettings, uint16_t* aConfigReg_p)
+{
+	if(aSettings->mSampleAveragingIdx < 0 || aSettings->mSampleAveragingIdx > cMaxSampleAvgTblIdx ||
+		aSettings->mBusConvTimeIdx < 0 || aSettings->mBusConvTimeIdx > cMaxConvTimeTblIdx ||
+		aSettings->mShuntConvTimeIdx < 0 || aSettings->mShuntConvTimeIdx > cMaxConvTimeTblIdx ||
+		aSettings->mOperatingMode < ShuntVoltageTriggered || aSettings->mOperatingMode > ShuntAndBusVoltageContinuous){
+		return BAD_PARAMETER;
+	}
+	//Bit 14 is reserved and always reads 1, keep it like the reset value
+	*aConfigReg_p = (cConfigResetValue & ~(cSampleAvgMask | cBusVoltageConvTimeMask | cShuntVoltageConvTimeMask | cOperatingModeMask)) |
+		((uint16_t)aSettings->mSampleAveragingIdx << cSampleAvgIdxShift) |
+		((uint16_t)aSettings->mBusConvTimeIdx << cBusVoltConvTimeIdxShift) |
+		((uint16_t)aSettings->mShuntConvTimeIdx << cShuntVoltConvTimeIdxShift) |
+		(uint16_t)aSettings->mOperatingMode;
+	return OK;
+}
+//----------------------------------------------------------------------------
+status INA226_Configure(INA226_config* this, const INA226_settings* aSettings)
+{
+	CHECK_INITIALIZED();
+
+	//Every field of the register is given, so there is nothing to read back first
+	uint16_t theConfig;
+	CALL_FN( INA226_EncodeSettings(aSettings, &theConfig) );
+	return INA226_WriteRegister(this,INA226_CONFIG, theConfig);
+}
+//----------------------------------------------------------------------------
+status INA226_GetSettings(INA226_config* this, INA226_settings* aSettings_p)
+{
+	CHECK_INITIALIZED();
+	CALL_FN( INA226_RefreshShadow(this,INA226_CONFIG) );
 
-	return INA226_WriteRegister(this,INA226_CONFIG, this->mConfigRegister);
+	aSettings_p->mSampleAveragingIdx = (this->mConfigRegister & cSampleAvgMask) >> cSampleAvgIdxShift;
+	aSettings_p->mBusConvTimeIdx = (this->mConfigRegister & cBusVoltageConvTimeMask) >> cBusVoltConvTimeIdxShift;
+	aSettings_p->mShuntConvTimeIdx = (this->mConfigRegister & cShuntVoltageConvTimeMask) >> cShuntVoltConvTimeIdxShift;
+	aSettings_p->mOperatingMode = (enum eOperatingMode)(this->mConfigRegister & cOperatingModeMask);
+	return OK;
+}
+//----------------------------------------------------------------------------
+uint32_t INA226_ConfigConversionPeriod_us(uint16_t aConfigRegister)
+{
+	uint16_t theMode = aConfigRegister & cOperatingModeMask;
+	uint32_t theConversionTime = 0;
+	if(theMode & cShuntConversionEnabled){
+		theConversionTime += caVoltageConvTimeMicroSecs[(aConfigRegister & cShuntVoltageConvTimeMask) >> cShuntVoltConvTimeIdxShift];
+	}
+	if(theMode & cBusConversionEnabled){
+		theConversionTime += caVoltageConvTimeMicroSecs[(aConfigRegister & cBusVoltageConvTimeMask) >> cBusVoltConvTimeIdxShift];
+	}
+	return theConversionTime * caNumSamplesAveraged[(aConfigRegister & cSampleAvgMask) >> cSampleAvgIdxShift];
+}
+//----------------------------------------------------------------------------
+uint32_t INA226_GetConversionPeriod_us(const INA226_config* this)
+{
+	return INA226_ConfigConversionPeriod_us(this->mConfigRegister);
 }
 //----------------------------------------------------------------------------
 status INA226_Debug_GetConfigRegister(INA226_config* this, uint16_t* aConfigReg_p)
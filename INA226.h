@@ -52,6 +52,8 @@ struct INA226_HardCodedChipConst;
 struct INA226_DefaultSettings;
 
 static const int INA226_I2C_TIMEOUT = 1000;
+static const int INA226_PROBE_TIMEOUT = 2; //used by INA226_Enumerate for the address scan
+static const int INA226_PROBE_TRIALS = 10; //Check_device trials of INA226_CheckI2cAddress by default
 
 //Most functions will return an error status
 typedef enum {OK=0, FAIL=-1,
@@ -61,16 +63,103 @@ typedef enum {OK=0, FAIL=-1,
     I2C_TRANSMISSION_ERROR = -5,
     BAD_PARAMETER = -6,
     NOT_INITIALIZED = -7,
-    INVALID_I2C_ADDRESS} status;
+    INVALID_I2C_ADDRESS,
+    INA226_BUSY = -8,
+    INA226_CONVERSION_TIMEOUT = -9,
+    INA226_DEGRADED = -10, //too many failures in a row, see INA226_SetFailurePolicy
+    INA226_OS_TIMEOUT = -11} status; //the transfer waited for didn't complete, see INA226_osal.h
+
+struct INA226_config;
+
+//Instrumentation. Define INA226_TRACE (for the whole project, it changes INA226_config) to count
+//every bus transaction in INA226_config.mStats and to call the tracer set with INA226_SetTracer
+//before and after it. Without INA226_TRACE nothing of this is compiled in.
+//INA226_TRACE_CYCLES() is the time base, e.g. #define INA226_TRACE_CYCLES() (DWT->CYCCNT)
+//on a Cortex-M3/M4/M7 (enable the DWT cycle counter first).
+#ifdef INA226_TRACE
+#ifndef INA226_TRACE_CYCLES
+#define INA226_TRACE_CYCLES()	0u
+#endif
+//Transport result counted as a timeout (HAL_TIMEOUT by default)
+#ifndef INA226_TRACE_TIMEOUT_RESULT
+#define INA226_TRACE_TIMEOUT_RESULT	3
+#endif
+
+enum eTraceEvent {  TraceTransmit = 1,
+                    TraceReceive,
+                    TraceWriteRead,
+                    TraceCheckDevice,
+                    TraceTransmitAsync,     //begin when the transfer is started, end when it completes
+                    TraceReceiveAsync,
+                    TraceReadRegisterAsync,
+                    TraceBegin = 0x80};     //ORed to the event for the call before the transaction
+
+//aCycles: INA226_TRACE_CYCLES() for TraceBegin, else the duration of the transaction.
+//aResult: the transport result (0 is OK), 0 for TraceBegin.
+typedef void (*INA226_TraceFn)(struct INA226_config* aConfig, uint8_t aEvent, uint8_t aRegister, int aResult, uint32_t aCycles);
+
+typedef struct INA226_stats{
+	uint32_t	mTransactions;
+	uint32_t	mBytes;             //address bytes included
+	uint32_t	mErrors;            //transport results other than 0
+	uint32_t	mTimeouts;          //transport results INA226_TRACE_TIMEOUT_RESULT
+	uint32_t	mRetries;           //transactions repeated by the driver
+	uint32_t	mTotalCycles;
+	uint32_t	mWorstCycles;       //longest transaction
+	uint8_t		mWorstEvent;
+	uint8_t		mWorstRegister;
+	uint8_t		mAsyncEvent;        //async transaction in flight
+	uint8_t		mAsyncRegister;
+	uint16_t	mAsyncBytes;
+	uint32_t	mAsyncStart;
+} INA226_stats;
+#endif
+
+//I2C transport of an INA226 instance. Every function returns 0 on success.
+//Each instance points to its own transport, so devices on different busses can use
+//different implementations (HAL DMA, polled, bit-banged, mocked, ...).
+//The default one (INA226_DefaultTransport) is in INA226_callback.c.
+typedef struct INA226_transport{
+	int		(*Transmit)(struct INA226_config* this, uint8_t* aData, uint16_t Size);
+	int		(*Receive)(struct INA226_config* this, uint8_t* buffer, uint16_t Size);
+	//Pointer write + read in one transaction (repeated START). Optional, may be NULL.
+	int		(*WriteRead)(struct INA226_config* this, uint8_t aRegister, uint8_t* buffer, uint16_t Size);
+	//Optional, may be NULL (every address is then reported as present)
+	int		(*Check_device)(struct INA226_config* this, uint8_t aI2C_Address, uint32_t Trials);
+	//Non-blocking transfers, optional, may be NULL if the ...Async functions are not used
+	int		(*Transmit_Async)(struct INA226_config* this, uint8_t* aData, uint16_t Size);
+	int		(*Receive_Async)(struct INA226_config* this, uint8_t* buffer, uint16_t Size);
+	int		(*ReadRegister_Async)(struct INA226_config* this, uint8_t aRegister, uint8_t* buffer, uint16_t Size);
+	void*	Context;	//user data for the transport, e.g. bit-bang pins or a mock register file
+} INA226_transport;
 
 typedef struct INA226_config{
 	void*				hi2c;
+	const INA226_transport*	mTransport;
 	bool     			mInitialized;
     uint8_t  			mI2C_Address;
     uint16_t 			mConfigRegister;        //local copy from the INA226
     uint16_t 			mCalibrationValue;        //local copy from the INA226
+    uint16_t 			mMaskEnableRegister;    //local copy from the INA226 (settings bits only)
+    uint16_t 			mAlertLimitRegister;    //local copy from the INA226
+    uint16_t 			mOperatingModeBeforeHibernate;
+    bool     			mTrustCache;            //reconfigure from the local copies without reading the chip
     int32_t  			mCurrentMicroAmpsPerBit; //This is the Current_LSB, as defined in the INA266 spec
     int32_t  			mPowerMicroWattPerBit;
+    uint8_t  			mRegisterPointer;       //last register pointer written to the INA226
+    bool     			mRegisterPointerValid;  //false after a bus error or before the first access
+    bool     			mStreamingReads;        //skip the pointer write when it is already latched
+    uint32_t 			mI2C_Timeout;           //passed to the blocking transfers (INA226_I2C_TIMEOUT by default)
+    uint32_t 			mBusTransactions;       //number of transport calls issued, free running (set to 0 to restart)
+    uint8_t  			mRetries;               //extra attempts of a failed blocking register access (0 by default)
+    uint8_t  			mProbeTrials;           //Check_device trials of INA226_CheckI2cAddress
+    uint8_t  			mDegradeAfter;          //consecutive failures before the device is degraded, 0: never (default)
+    uint8_t  			mFailures;              //consecutive failed register accesses
+    volatile bool		mDegraded;              //accesses fail fast with INA226_DEGRADED until INA226_Reprobe succeeds
+#ifdef INA226_TRACE
+    INA226_stats		mStats;
+    INA226_TraceFn		mTracer;                //may be NULL
+#endif
 } INA226_config;
 
 typedef struct INA226_result{
@@ -78,11 +167,86 @@ typedef struct INA226_result{
     int32_t 			BusVoltage_uV;        //local copy from the INA226
     int32_t  			Current_uA; //This is the Current_LSB, as defined in the INA266 spec
     int32_t  			Power_uW;
+    uint32_t			Timestamp;  //midpoint of the conversion window, clock of INA226_SetClock (0 without clock)
 } INA226_result;
 
+//Raw register values of one measurement (8 bytes, in register address order), converted
+//to micro units later and in bulk with INA226_ConvertRawBatch
+typedef struct INA226_raw{
+    int16_t 			ShuntVoltage;           //2.5uV per bit
+    uint16_t			BusVoltage;             //1.25mV per bit
+    uint16_t			Power;                  //mPowerMicroWattPerBit per bit
+    int16_t 			Current;                //mCurrentMicroAmpsPerBit per bit
+} INA226_raw;
+
+//Callback invoked (usually from interrupt context) when an asynchronous acquisition finishes
+typedef void (*INA226_AsyncCallback)(struct INA226* this, status aStatus);
+
+#define INA226_ASYNC_MAX_STEPS	6 //MASK_ENABLE + the four measurement registers + a queued CONFIG write
+
+enum eAsyncState {AsyncIdle = 0,
+                  AsyncBusy = 1};
+
+//State of the non-blocking register read sequence, driven by the transfer complete interrupts
+typedef struct INA226_async{
+	volatile uint8_t		mState;
+	uint8_t					mCount;      //number of registers in the sequence
+	uint8_t					mIndex;      //register currently on the bus
+	uint8_t					mPhase;      //pointer write or data read, when the transport has no ReadRegister_Async
+	bool					mConvert;    //update Result at the end, or only Raw
+	uint8_t					mWrites;     //bit i set: step i writes mValues[i] to mRegisters[i] instead of reading it
+	uint8_t					mRegisters[INA226_ASYNC_MAX_STEPS];
+	uint16_t				mValues[INA226_ASYNC_MAX_STEPS];
+	uint8_t					mBuffer[3];  //DMA source/target, must stay valid until the transfer completes
+	INA226_AsyncCallback	mOnComplete;
+	void*					mUserData;   //free for the application
+	//The modules driving the engine, each finds its state through its own field (NULL: unused)
+	struct INA226_Bus*		mBus;
+	struct INA226_supervisor* mSupervisor;
+	struct INA226_osal*		mOsal;
+	bool					mProbing;    //INA226_ReprobeAsync in progress, allowed while degraded
+	uint16_t				mSaved[4];   //shadows of CONFIG, MASK_ENABLE, ALERT_LIMIT, CALIBRATION while probing
+	INA226_AsyncCallback	mOnProbed;
+	uint32_t				mTimestamp;  //Result.Timestamp of the sequence in flight
+} INA226_async;
+
+struct INA226_ring;
+
+//Monotonic clock used to timestamp samples, in microseconds (free running, may wrap)
+typedef uint32_t (*INA226_ClockFn)(void);
+//Busy wait or sleep, in microseconds
+typedef void (*INA226_DelayFn)(uint32_t aMicroSeconds);
+
+//Conversion-ready driven acquisition, see INA226_StartConversionReadyAcquisition
+typedef struct INA226_acquisition{
+	bool					mRunning;
+	INA226_ClockFn			mClock;      //may be NULL, timestamps are 0 then
+	uint32_t				mAlertTimestamp; //midpoint of the conversion the ALERT pin signalled
+	uint8_t					mSelection;  //eMeasureSelect flags read after every conversion
+	struct INA226_ring*		mRing;       //every new sample is pushed here, may be NULL
+	INA226_AsyncCallback	mOnSample;   //called after the sample is pushed, may be NULL
+	volatile uint32_t		mSamples;    //samples acquired
+	volatile uint32_t		mOverruns;   //ALERT edges that found the bus busy, each read late (and the conversions in between lost)
+	volatile uint32_t		mDropped;    //samples lost because the ring was full
+	volatile uint32_t		mErrors;     //failed reads
+	struct INA226_energy*	mEnergy;     //integrates every sample, may be NULL (see INA226_energy.h)
+	uint32_t				mLostAtLastSample; //mOverruns + mErrors when mEnergy was last updated
+	volatile bool			mConfigPending; //see INA226_QueueConfigWrite
+	uint16_t				mPendingConfig;
+	volatile bool			mAlertPending; //conversion ready flag not read yet (bus busy or failed read), the ALERT pin is still asserted
+	uint32_t				mPendingTimestamp;
+	uint8_t					mAlertFailures; //failed reads in a row
+	volatile uint8_t		mTriggerState; //single-shot conversion, see INA226_TriggerAndReadAsync
+	uint8_t					mTriggerSelection;
+	INA226_AsyncCallback	mOnTrigger;
+} INA226_acquisition;
+
 typedef struct INA226{
-	INA226_config	Config;
-	INA226_result	Result;
+	INA226_config		Config;
+	INA226_result		Result;
+	INA226_raw			Raw;         //register values of the last measurement
+	INA226_async		Async;
+	INA226_acquisition	Acquisition;
 }INA226;
 
 //=============================================================================
@@ -104,6 +268,13 @@ enum eAlertTrigger {ClearTriggers                = 0x0000, //default
                     PowerOverLimit               = 0x0800,
                     ConversionReady              = 0x0400};
 
+//Selection of measurements for INA226_Measure / INA226_MeasureAsync, can be ORed together
+enum eMeasureSelect {MeasureShuntVoltage          = 0x01,
+                    MeasureBusVoltage            = 0x02,
+                    MeasureCurrent               = 0x04,
+                    MeasurePower                 = 0x08,
+                    MeasureEverything            = 0x0F};
+
 enum eAlertTriggerCause{
                     Unknown=0,
                     AlertFunctionFlag            = 0x10,
@@ -112,6 +283,36 @@ enum eAlertTriggerCause{
                     AlertPolarityBit             = 0x02};
 //=============================================================================
 
+//All fields of the configuration register, written at once by INA226_Configure.
+//The indices are the ones of the tables in the INA226 spec (see below).
+typedef struct INA226_settings{
+	int					mSampleAveragingIdx;	//index to caNumSamplesAveraged, 0..7
+	int					mBusConvTimeIdx;		//index to caVoltageConvTimeMicroSecs, 0..7
+	int					mShuntConvTimeIdx;		//index to caVoltageConvTimeMicroSecs, 0..7
+	enum eOperatingMode	mOperatingMode;
+} INA226_settings;
+
+//Tables of the INA226 spec, indexed by the fields of the configuration register
+extern const uint16_t caNumSamplesAveraged[8];			//1, 4, 16, 64, 128, 256, 512, 1024
+extern const uint16_t caVoltageConvTimeMicroSecs[8];	//140, 204, 332, 588, 1100, 2116, 4156, 8244
+//=============================================================================
+
+//	Register addresses of the INA226
+#define INA226_CONFIG_REG			0x00
+#define INA226_SHUNT_VOLTAGE_REG	0x01 // readonly
+#define INA226_BUS_VOLTAGE_REG		0x02 // readonly
+#define INA226_POWER_REG			0x03 // readonly
+#define INA226_CURRENT_REG			0x04 // readonly
+#define INA226_CALIBRATION_REG		0x05
+#define INA226_MASK_ENABLE_REG		0x06
+#define INA226_ALERT_LIMIT_REG		0x07
+#define INA226_MANUFACTURER_ID_REG	0xFE // readonly
+#define INA226_DIE_ID_REG			0xFF // readonly
+
+#define INA226_BUS_VOLTAGE_LSB_UV	1250 //bus voltage register, uV per bit
+#define INA226_POWER_LSB_RATIO		25   //Power_LSB = 25 * Current_LSB
+//=============================================================================
+
 //	Address of INA226 I2C for more info see the INA226 datasheet
 #define INA226_ADRESS_0		0b01000000
 #define INA226_ADRESS_1		0b01000001
@@ -134,15 +335,118 @@ enum eAlertTriggerCause{
 void INA226_Constructor(INA226_config* this, void* i2c_device, uint8_t aI2C_Address);
 status INA226_CheckI2cAddress(INA226_config* this, uint8_t aI2C_Address);
 
+//Integer calibration, usable in constant expressions (e.g. to keep the calibration word in flash).
+//Current_LSB in uA, rounded up so that aMaxCurrent_uA still fits the 15 bit current register.
+#define INA226_CURRENT_LSB_UA(aMaxCurrent_uA)	((uint32_t)(((uint64_t)(aMaxCurrent_uA) + 32766u) / 32767u))
+//CAL = 0.00512 / (Current_LSB[A] * R[Ohm]) = 5120000000 / (Current_LSB[uA] * R[uOhm])
+#define INA226_CALIBRATION_VALUE_U64(aShuntResistor_uOhms, aMaxCurrent_uA) \
+	(5120000000ULL / ((uint64_t)INA226_CURRENT_LSB_UA(aMaxCurrent_uA) * (uint64_t)(aShuntResistor_uOhms)))
+#define INA226_CALIBRATION_VALUE(aShuntResistor_uOhms, aMaxCurrent_uA) \
+	((uint16_t)INA226_CALIBRATION_VALUE_U64(aShuntResistor_uOhms, aMaxCurrent_uA))
+#define INA226_CALIBRATION_MAX		0x7FFF //bit 15 of the calibration register is not used
+
 //Resets the INA226 and configures it according to the supplied parameters - should be called first.
 //status INA226_Init(uint8_t aI2C_Address=0x40, double aShuntResistor_Ohms=0.1, double aMaxCurrent_Amps=3.2767);
+//Integer only version: the shunt in micro ohms, the max current in micro amps.
+//aTransport may be NULL for INA226_DefaultTransport.
+status INA226_InitFixedPoint(INA226* this, const INA226_transport* aTransport, void* i2c_device, uint8_t aI2C_Address, uint32_t aShuntResistor_uOhms, uint32_t aMaxCurrent_uA);
+//Same with the configuration register word and the calibration computed beforehand
+//(e.g. as constants, see INA226_static.h). aTransport may be NULL for INA226_DefaultTransport.
+status INA226_InitPrecomputed(INA226* this, const INA226_transport* aTransport, void* i2c_device, uint8_t aI2C_Address,
+		uint16_t aConfigRegister, uint16_t aCalibrationValue, int32_t aCurrentMicroAmpsPerBit);
+//The double versions below only convert the arguments to micro units. Define INA226_NO_FLOAT
+//to leave them out on parts without FPU, so no floating point code is linked at all.
+#ifndef INA226_NO_FLOAT
 status INA226_Init(INA226* this, void* i2c_device, uint8_t aI2C_Address, double aShuntResistor_Ohms, double aMaxCurrent_Amps);
+//Same as INA226_Init but the device is accessed through aTransport instead of INA226_DefaultTransport
+status INA226_InitWithTransport(INA226* this, const INA226_transport* aTransport, void* i2c_device, uint8_t aI2C_Address, double aShuntResistor_Ohms, double aMaxCurrent_Amps);
+#endif
+
+//Scans INA226_ADRESS_0..INA226_ADRESS_15 with one short probe per address and initializes every
+//INA226 found (same shunt and max current for all, in micro ohms and micro amps), one step for all
+//of them before the next one.
+//The initialized devices are stored at aDevices[0..*aFoundCount_p-1], aDevices must hold aMaxDevices
+//(up to 16). A device whose initialization fails is left out, the others are still initialized.
+status INA226_Enumerate(INA226* aDevices, uint8_t aMaxDevices, const INA226_transport* aTransport, void* i2c_device,
+		uint32_t aShuntResistor_uOhms, uint32_t aMaxCurrent_uA, uint8_t* aFoundCount_p);
 
 int32_t INA226_GetShuntVoltage_uV(INA226*);
 int32_t INA226_GetBusVoltage_uV(INA226*);
 int32_t INA226_GetCurrent_uA(INA226*);
 int32_t INA226_GetPower_uW(INA226*);
-status INA226_MeasureAll(INA226* this);
+//Reads the selected registers (eMeasureSelect flags) back-to-back and fills Result in one go.
+//Result is only modified when every read succeeded, the return value is the real bus status.
+status INA226_Measure(INA226* this, uint8_t aSelection);
+status INA226_MeasureAll(INA226* this); //same as INA226_Measure(this, MeasureEverything)
+
+//Non-blocking version of INA226_Measure. Starts the first register read and returns immediately,
+//the rest of the sequence is driven by INA226_AsyncTransferComplete. When all selected registers
+//are read, Result is updated and aOnComplete (may be NULL) is called.
+status INA226_MeasureAsync(INA226* this, uint8_t aSelection, INA226_AsyncCallback aOnComplete);
+status INA226_MeasureAllAsync(INA226* this, INA226_AsyncCallback aOnComplete);
+bool   INA226_AsyncIsBusy(INA226* this);
+//Single register access through the same engine, to chain sequences from interrupts.
+//The value read is in this->Async.mValues[0] when aOnComplete is called.
+status INA226_ReadRegisterAsync(INA226* this, uint8_t aRegister, INA226_AsyncCallback aOnComplete);
+//Writes aValues[i] to aRegisters[i], up to INA226_ASYNC_MAX_STEPS registers, in order
+status INA226_WriteRegistersAsync(INA226* this, const uint8_t* aRegisters, const uint16_t* aValues, uint8_t aCount, INA226_AsyncCallback aOnComplete);
+//Call these from HAL_I2C_MemRxCpltCallback / HAL_I2C_ErrorCallback (or your DMA/IRQ handler)
+void   INA226_AsyncTransferComplete(INA226* this);
+void   INA226_AsyncTransferError(INA226* this);
+
+//Raw sample mode: the selected registers are only stored (in *aRaw_p and Raw), not converted.
+//Convert them later, off the interrupt, with INA226_ConvertRawBatch.
+status INA226_MeasureRaw(INA226* this, uint8_t aSelection, INA226_raw* aRaw_p);
+status INA226_MeasureRawAsync(INA226* this, uint8_t aSelection, INA226_AsyncCallback aOnComplete);
+//Converts aCount raw samples to micro units with the scaling of this device
+//The Timestamp of aResult_p is not touched
+void   INA226_ConvertRawBatch(const INA226_config* this, const INA226_raw* aRaw, INA226_result* aResult_p, uint32_t aCount);
+
+//Conversion-ready acquisition. Configures the ALERT pin to signal every finished conversion.
+//Call INA226_AlertPinISR from the EXTI handler of the ALERT pin (falling edge): it reads MASK_ENABLE
+//(which releases the pin) and the selected registers asynchronously and pushes the new raw sample
+//to aRing (may be NULL). So there is exactly one bus read sequence per new conversion.
+//Result is not updated in this mode, use Raw or the samples of the ring.
+//The pin only releases when MASK_ENABLE is read, so no edge comes while it waits: an edge that finds
+//the bus busy is read at the end of the running sequence (counted in mOverruns), a failed read is
+//retried from the completion interrupt a few times. If the transport can fail for longer, call
+//INA226_AcquisitionPoll from a slow timer or the main loop, it restarts the read that releases the
+//pin (and does nothing otherwise).
+status INA226_StartConversionReadyAcquisition(INA226* this, uint8_t aSelection, struct INA226_ring* aRing, INA226_AsyncCallback aOnSample);
+status INA226_StopConversionReadyAcquisition(INA226* this);
+void   INA226_AlertPinISR(INA226* this);
+void   INA226_AcquisitionPoll(INA226* this);
+//Sets the clock used to timestamp Result and the samples pushed to the ring.
+//The timestamp is the midpoint of the conversion window (averaging * enabled conversion times of
+//the configuration register), when the sample was taken rather than when it was read:
+//  - conversion ready (ALERT pin) and triggered conversions: end of conversion - period / 2
+//  - reads in continuous mode: the last result is on average period / 2 old, read time - period
+//so samples of several devices with different settings can be aligned on one time base.
+status INA226_SetClock(INA226* this, INA226_ClockFn aClock);
+//Integrates the power and current of every acquired sample into aCounter (may be NULL to detach).
+//aSelection must include MeasurePower and MeasureCurrent. Conversions lost to overruns or read
+//errors are accounted for with the values of the next sample.
+status INA226_SetEnergyCounter(INA226* this, struct INA226_energy* aCounter);
+//Writes the configuration register. While the conversion-ready acquisition runs the write is
+//appended to the next read sequence of INA226_AlertPinISR, so it never collides with the
+//transfers of the interrupt (and an attached energy counter follows the new conversion period).
+//Otherwise it is written right away.
+status INA226_QueueConfigWrite(INA226* this, uint16_t aConfigRegister);
+
+//Single-shot conversion. aMode is ShuntVoltageTriggered, BusVoltageTriggered or ShuntAndBusTriggered.
+//One write of the configuration register (from the local copy, no read) starts the conversion,
+//then it waits for the conversion time of the current averaging / conversion time settings, polls
+//the conversion ready flag and reads only the selected registers into Result.
+//aDelay may be NULL, it only polls then. Returns INA226_CONVERSION_TIMEOUT if the conversion doesn't
+//finish within twice the expected time.
+status INA226_TriggerAndRead(INA226* this, enum eOperatingMode aMode, uint8_t aSelection, INA226_DelayFn aDelay);
+//Non-blocking version. *aReadyIn_us_p (may be NULL) is the time after which the conversion is done
+//(nominal time + 10%). Then either INA226_AlertPinISR (ALERT pin configured for ConversionReady) or
+//INA226_TriggerTimerElapsed (from a timer) checks the conversion ready flag and reads the registers.
+//aOnComplete is called with OK when Result is updated, or with INA226_BUSY if the conversion
+//wasn't finished yet: call INA226_TriggerTimerElapsed again a bit later.
+status INA226_TriggerAndReadAsync(INA226* this, enum eOperatingMode aMode, uint8_t aSelection, INA226_AsyncCallback aOnComplete, uint32_t* aReadyIn_us_p);
+void   INA226_TriggerTimerElapsed(INA226* this);
 
 status INA226_SetOperatingMode(INA226_config*,enum eOperatingMode aOpMode);
 status INA226_Hibernate(INA226_config*); //Enters a very low power mode, no voltage measurements
@@ -150,20 +454,78 @@ status INA226_Wakeup(INA226_config*);    //Wake-up and enter the last operating
 
 //The trigger value is in microwatts or microvolts, depending on the trigger
 status INA226_ConfigureAlertPinTrigger(INA226_config*,enum eAlertTrigger aAlertTrigger, int32_t aValue, bool aLatching);
+//Builds the MASK_ENABLE and ALERT_LIMIT register values for a trigger, without touching the device.
+//NOT_INITIALIZED until the device is initialized (the power limit needs the calibration).
+status INA226_EncodeAlertTrigger(const INA226_config*,enum eAlertTrigger aAlertTrigger, int32_t aValue, bool aLatching,
+		uint16_t* aMaskEnable_p, uint16_t* aAlertLimit_p);
 //status INA226_ResetAlertPin(INA226_config*);
 status INA226_ResetAlertPin(INA226_config*,enum  eAlertTriggerCause* aAlertTriggerCause_p ); //provides feedback as to what caused the alert
 
 //The parameters for the two functions below are indices into the tables defined in the INA226 spec
-//These tables are copied below for your information (caNumSamplesAveraged & caVoltageConvTimeMicroSecs)
+//(caNumSamplesAveraged & caVoltageConvTimeMicroSecs above). INA226_Plan (INA226_plan.h) picks them
+//for a target output period and noise level.
 status INA226_ConfigureVoltageConversionTime(INA226_config*,int aIndexToConversionTimeTable);
 status INA226_ConfigureNumSampleAveraging(INA226_config*,int aIndexToSampleAverageTable);
+//Separate bus and shunt conversion times, one write of the configuration register
+status INA226_ConfigureConversionTimes(INA226_config*,int aBusIndex, int aShuntIndex);
+//Averaging, both conversion times and the operating mode with a single write of the configuration
+//register (the device restarts the conversion once instead of after every setting)
+status INA226_Configure(INA226_config*,const INA226_settings* aSettings);
+//Decodes the settings from the local copy of the configuration register
+status INA226_GetSettings(INA226_config*,INA226_settings* aSettings_p);
+//Builds the configuration register value for aSettings, without touching the device
+status INA226_EncodeSettings(const INA226_settings* aSettings, uint16_t* aConfigReg_p);
+//Time between two results (averaging * enabled conversion times) for the local copy of the
+//configuration register, in microseconds, 0 when shut down. Nominal value, the internal
+//oscillator of the INA226 is specified to +-10%.
+uint32_t INA226_GetConversionPeriod_us(const INA226_config*);
+uint32_t INA226_ConfigConversionPeriod_us(uint16_t aConfigRegister); //same for any configuration word
 status INA226_Debug_GetConfigRegister(INA226_config*,uint16_t* aConfigReg_p);
 
+//Shadow registers. CONFIG, CALIBRATION, MASK_ENABLE and ALERT_LIMIT are cached write-through in
+//INA226_config. With the cache trusted, reconfiguration (operating mode, averaging, conversion time,
+//hibernate, alert trigger) writes the register without reading it first.
+//Call INA226_ResyncShadowRegisters if something else (another master, a power cycle) may have changed
+//the device. Note that it reads MASK_ENABLE, which also clears a latched alert.
+status INA226_SetTrustCache(INA226_config*, bool aEnable);
+status INA226_ResyncShadowRegisters(INA226_config*);
+
+//"Locked register" streaming mode. The INA226 keeps its register pointer latched, so when enabled
+//a read of the same register as the previous access is a single 2 byte read without pointer write.
+//Only use it if no other master touches the device. Disabled by default.
+status INA226_SetStreamingReads(INA226_config*, bool aEnable);
+
+//Timeouts and failures. INA226_SetBusSpeed sets mI2C_Timeout (HAL milliseconds) to a few times the
+//longest transfer at aBusSpeed_Hz instead of INA226_I2C_TIMEOUT, and the probe to 2 trials, so a hung
+//or unplugged device costs a few milliseconds per access instead of a second.
+status INA226_SetBusSpeed(INA226_config*, uint32_t aBusSpeed_Hz);
+//A failed blocking access is repeated aRetries times. After aDegradeAfter failed accesses in a row
+//(0: never) the device is degraded: every access returns INA226_DEGRADED without touching the bus
+//and INA226_Bus skips it, only re-probing it periodically.
+status INA226_SetFailurePolicy(INA226_config*, uint8_t aRetries, uint8_t aDegradeAfter);
+bool   INA226_IsDegraded(INA226_config*);
+//One read of the calibration register. If the device answers it is healthy again: if it lost its
+//settings in the meantime (power cycle, re-plugged) CONFIG, CALIBRATION, MASK_ENABLE and ALERT_LIMIT
+//are restored from the local copies. The local copies are kept if the restore fails, so the next
+//reprobe restores the device again.
+status INA226_Reprobe(INA226_config*);
+//Same with the non-blocking functions, aOnComplete gets OK once the device is healthy again
+status INA226_ReprobeAsync(INA226* this, INA226_AsyncCallback aOnComplete);
+
+#ifdef INA226_TRACE
+status INA226_SetTracer(INA226_config*, INA226_TraceFn aTracer);
+void   INA226_ResetStats(INA226_config*);
+#endif
+
 //Private functions
 
 status INA226_WriteRegister(INA226_config*,uint8_t aRegister, uint16_t aValue);
 status INA226_ReadRegister(INA226_config*,uint8_t aRegister, uint16_t* aValue_p);
+status INA226_ReadRegisters(INA226_config*,const uint8_t* aRegisters, uint16_t* aValues_p, uint8_t aCount);
+status INA226_setupCalibrationFixedPoint(INA226_config*,uint32_t aShuntResistor_uOhms, uint32_t aMaxCurrent_uA);
+#ifndef INA226_NO_FLOAT
 status INA226_setupCalibration(INA226_config*,double aShuntResistor_Ohms, double aMaxCurrent_Amps);
+#endif
 
 
 
@@ -0,0 +1,107 @@
+/*
+ * INA226_adaptive.c
+ *
+ * Adaptive averaging / conversion time controller, see INA226_adaptive.h
+ */
+
+#include "INA226_adaptive.h"
+#include "INA226_internal.h"
+#include <stddef.h>
+
+//----------------------------------------------------------------------------
+static void INA226_Adaptive_ClearWindow(INA226_adaptive* this)
+{
+	this->mCount = 0;
+	this->mSum = 0;
+	this->mSumOfSquares = 0;
+}
+//----------------------------------------------------------------------------
+static status INA226_Adaptive_Switch(INA226_adaptive* this, bool aSteady)
+{
+	this->mSteady = aSteady;
+	this->mSkipNext = true;
+	this->mQuietWindows = 0;
+	this->mSwitches++;
+	INA226_Adaptive_ClearWindow(this);
+	return INA226_QueueConfigWrite(this->mDevice, aSteady ? this->mSteadyConfig : this->mFastConfig);
+}
+//----------------------------------------------------------------------------
+status INA226_Adaptive_Init(INA226_adaptive* this, INA226* aDevice, const INA226_settings* aFast, const INA226_settings* aSteady,
+		uint32_t aQuietStdDev_uA, uint32_t aTransientStep_uA)
+{
+	if(aDevice->Config.mCurrentMicroAmpsPerBit <= 0){
+		return NOT_INITIALIZED;
+	}
+	CALL_FN( INA226_EncodeSettings(aFast, &this->mFastConfig) );
+	CALL_FN( INA226_EncodeSettings(aSteady, &this->mSteadyConfig) );
+	uint32_t theLSB = (uint32_t)aDevice->Config.mCurrentMicroAmpsPerBit;
+	this->mDevice = aDevice;
+	this->mQuietStdDev = (aQuietStdDev_uA + theLSB - 1) / theLSB;
+	this->mTransientStep = (aTransientStep_uA + theLSB - 1) / theLSB;
+	if(this->mTransientStep <= this->mQuietStdDev){
+		return BAD_PARAMETER;
+	}
+	this->mWindow = INA226_ADAPTIVE_WINDOW;
+	this->mQuietWindowsRequired = INA226_ADAPTIVE_QUIET_WINDOWS;
+	this->mSteadyMean = 0;
+	this->mSwitches = 0;
+	CALL_FN( INA226_Adaptive_Switch(this, false) );
+	this->mSwitches = 0;
+	return OK;
+}
+//----------------------------------------------------------------------------
+status INA226_Adaptive_Add(INA226_adaptive* this, const INA226_raw* aRaw)
+{
+	if(this->mSkipNext){
+		this->mSkipNext = false;
+		return OK;
+	}
+	int32_t theCurrent = aRaw->Current;
+
+	if(this->mSteady){
+		//Every steady sample is already an average, a step away from the mean is a transient
+		int32_t theDeviation = theCurrent - (this->mSteadyMean >> 4);
+		if(theDeviation < 0){
+			theDeviation = -theDeviation;
+		}
+		if((uint32_t)theDeviation >= this->mTransientStep){
+			return INA226_Adaptive_Switch(this, false);
+		}
+		this->mSteadyMean += (theCurrent * 16 - this->mSteadyMean) / 8; //slow moving average
+		return OK;
+	}
+
+	this->mSum += theCurrent;
+	this->mSumOfSquares += (uint64_t)((int64_t)theCurrent * theCurrent);
+	if(++this->mCount < this->mWindow){
+		return OK;
+	}
+	//n^2 * variance = n * sum(x^2) - sum(x)^2, compared without a division
+	uint64_t theN = this->mCount;
+	uint64_t theScaledVariance = theN * this->mSumOfSquares - (uint64_t)(this->mSum * this->mSum);
+	uint64_t theScaledLimit = theN * theN * this->mQuietStdDev * this->mQuietStdDev;
+	int32_t theMean = (int32_t)(this->mSum / (int64_t)theN);
+	INA226_Adaptive_ClearWindow(this);
+	if(theScaledVariance >= theScaledLimit){
+		this->mQuietWindows = 0;
+		return OK;
+	}
+	if(++this->mQuietWindows < this->mQuietWindowsRequired){
+		return OK;
+	}
+	this->mSteadyMean = theMean * 16;
+	return INA226_Adaptive_Switch(this, true);
+}
+//----------------------------------------------------------------------------
+status INA226_Adaptive_AddSamples(INA226_adaptive* this, const INA226_sample* aSamples, uint32_t aCount)
+{
+	for(uint32_t i = 0; i < aCount; i++){
+		CALL_FN( INA226_Adaptive_Add(this, &aSamples[i].Raw) );
+	}
+	return OK;
+}
+//----------------------------------------------------------------------------
+bool INA226_Adaptive_IsSteady(const INA226_adaptive* this)
+{
+	return this->mSteady;
+}
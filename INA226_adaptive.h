@@ -0,0 +1,49 @@
+/*
+ * INA226_adaptive.h
+ *
+ * Adaptive averaging / conversion time. Starts with the "fast" settings (little or no averaging,
+ * every transient is seen) and switches to the "steady" settings (heavy averaging, 16..64 times
+ * fewer samples to read and process) once the current has been quiet for a while. A single
+ * steady sample that moves away from the steady mean switches back to the fast settings at once.
+ * Each switch is one write of the configuration register, queued with INA226_QueueConfigWrite.
+ * Feed it from a task with the samples popped from the ring (or with polled raw values).
+ */
+
+#ifndef INA226_INA226_ADAPTIVE_H_
+#define INA226_INA226_ADAPTIVE_H_
+
+#include "INA226.h"
+#include "INA226_ring.h"
+
+#define INA226_ADAPTIVE_WINDOW			64	//fast samples per variance window
+#define INA226_ADAPTIVE_QUIET_WINDOWS	4	//quiet windows in a row before going steady
+
+typedef struct INA226_adaptive{
+	INA226*		mDevice;
+	uint16_t	mFastConfig;		//configuration register words of both states
+	uint16_t	mSteadyConfig;
+	uint32_t	mQuietStdDev;		//current register LSBs, quiet below this standard deviation
+	uint32_t	mTransientStep;		//current register LSBs, a steady sample this far from the mean is a transient
+	uint16_t	mWindow;			//INA226_ADAPTIVE_WINDOW by default
+	uint8_t		mQuietWindowsRequired;	//INA226_ADAPTIVE_QUIET_WINDOWS by default
+	bool		mSteady;
+	bool		mSkipNext;			//the first sample after a switch may still be from the old settings
+	uint8_t		mQuietWindows;
+	uint16_t	mCount;				//statistics of the current window
+	int64_t		mSum;
+	uint64_t	mSumOfSquares;
+	int32_t		mSteadyMean;		//raw current, 1/16 LSB
+	uint32_t	mSwitches;
+} INA226_adaptive;
+
+//aQuietStdDev_uA: the current counts as steady below this standard deviation.
+//aTransientStep_uA: should be well above aQuietStdDev_uA (hysteresis).
+//Writes the fast settings.
+status	INA226_Adaptive_Init(INA226_adaptive* this, INA226* aDevice, const INA226_settings* aFast, const INA226_settings* aSteady,
+			uint32_t aQuietStdDev_uA, uint32_t aTransientStep_uA);
+//One sample, returns the status of the configuration write when it switches
+status	INA226_Adaptive_Add(INA226_adaptive* this, const INA226_raw* aRaw);
+status	INA226_Adaptive_AddSamples(INA226_adaptive* this, const INA226_sample* aSamples, uint32_t aCount);
+bool	INA226_Adaptive_IsSteady(const INA226_adaptive* this);
+
+#endif /* INA226_INA226_ADAPTIVE_H_ */
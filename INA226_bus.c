@@ -0,0 +1,386 @@
+/*
+ * INA226_bus.c
+ *
+ * Scheduler for several INA226 devices sharing one I2C peripheral, see INA226_bus.h
+ */
+
+#include "INA226_bus.h"
+#include "INA226_ring.h"
+#include <stddef.h>
+
+enum eSnapshotState {SnapshotIdle = 0,
+                     SnapshotTriggering = 1,
+                     SnapshotHarvesting = 2,
+                     SnapshotRestoring = 3};
+
+static const uint16_t cOperatingModeBits = 0x0007;
+
+//Time comparison that survives the wrap of the 32 bit clock
+static bool INA226_Bus_IsDue(uint32_t aNow, uint32_t aDue)
+{
+	return (int32_t)(aNow - aDue) >= 0;
+}
+//----------------------------------------------------------------------------
+status INA226_Bus_Init(INA226_Bus* this, INA226_ClockFn aClock, INA226_BusCallback aOnSample)
+{
+	if(aClock == NULL){
+		return BAD_PARAMETER;
+	}
+	this->mCount = 0;
+	this->mActive = -1;
+	this->mLastServed = 0;
+	this->mClock = aClock;
+	this->mOnSample = aOnSample;
+	this->mReprobePeriod_us = INA226_BUS_REPROBE_PERIOD_US;
+	this->mSnapshotState = SnapshotIdle;
+	this->mOnSnapshot = NULL;
+	INA226_Bus_ResetStatistics(this);
+	return OK;
+}
+//----------------------------------------------------------------------------
+status INA226_Bus_Add(INA226_Bus* this, INA226* aDevice, uint32_t aPeriod_us, uint8_t aPriority, uint8_t aSelection)
+{
+	if(this->mCount >= INA226_BUS_MAX_DEVICES || aDevice == NULL || aPeriod_us == 0 || (aSelection & MeasureEverything) == 0){
+		return BAD_PARAMETER;
+	}
+	if(!aDevice->Config.mInitialized){
+		return NOT_INITIALIZED;
+	}
+	if(aDevice->Async.mBus != NULL){
+		return INA226_BUSY; //already scheduled by a bus
+	}
+	INA226_bus_entry* theEntry = &this->mEntries[this->mCount];
+	theEntry->mDevice = aDevice;
+	theEntry->mPeriod_us = aPeriod_us;
+	theEntry->mNextDue = this->mClock();
+	theEntry->mPriority = aPriority;
+	theEntry->mSelection = aSelection;
+	theEntry->mSamples = 0;
+	theEntry->mMissed = 0;
+	theEntry->mErrors = 0;
+	theEntry->mReprobeDue = theEntry->mNextDue;
+	theEntry->mReprobes = 0;
+	theEntry->mInSnapshot = false;
+	aDevice->Async.mBus = this;
+	this->mCount++;
+	return OK;
+}
+//----------------------------------------------------------------------------
+//Highest priority due device, ties broken round-robin starting after the last served one.
+//Returns -1 if nothing is due.
+static int8_t INA226_Bus_SelectNext(INA226_Bus* this, uint32_t aNow)
+{
+	int8_t theBest = -1;
+	for(uint8_t i = 1; i <= this->mCount; i++){
+		uint8_t theIndex = (this->mLastServed + i) % this->mCount;
+		INA226_bus_entry* theEntry = &this->mEntries[theIndex];
+		uint32_t theDue = theEntry->mDevice->Config.mDegraded ? theEntry->mReprobeDue : theEntry->mNextDue;
+		if(!INA226_Bus_IsDue(aNow, theDue)){
+			continue;
+		}
+		if(theBest < 0 || theEntry->mPriority > this->mEntries[theBest].mPriority){
+			theBest = theIndex;
+		}
+	}
+	return theBest;
+}
+//----------------------------------------------------------------------------
+static void INA226_Bus_DeviceComplete(INA226* aDevice, status aStatus)
+{
+	INA226_Bus* this = aDevice->Async.mBus;
+	uint8_t theIndex = (uint8_t)this->mActive;
+	INA226_bus_entry* theEntry = &this->mEntries[theIndex];
+	uint32_t theNow = this->mClock();
+
+	this->mBusyTime_us += theNow - this->mTransferStart;
+	if(aStatus == OK){
+		theEntry->mSamples++;
+		if(aDevice->Acquisition.mRing != NULL){
+			INA226_sample theSample;
+			//Middle of the conversion window, like the samples of the driver (see INA226_SetClock)
+			theSample.Timestamp = this->mTransferStart - INA226_GetConversionPeriod_us(&aDevice->Config);
+			theSample.Raw = aDevice->Raw;
+			if(!INA226_Ring_Push(aDevice->Acquisition.mRing, &theSample)){
+				aDevice->Acquisition.mDropped++;
+			}
+		}
+	}else{
+		theEntry->mErrors++;
+	}
+	this->mActive = -1;
+
+	if(this->mOnSample != NULL){
+		this->mOnSample(this, theIndex, aStatus);
+	}
+	//Keep the bus busy with the next due device
+	INA226_Bus_Poll(this);
+}
+//----------------------------------------------------------------------------
+static void INA226_Bus_DeviceReprobed(INA226* aDevice, status aStatus)
+{
+	INA226_Bus* this = aDevice->Async.mBus;
+	INA226_bus_entry* theEntry = &this->mEntries[(uint8_t)this->mActive];
+	uint32_t theNow = this->mClock();
+
+	this->mBusyTime_us += theNow - this->mTransferStart;
+	if(aStatus == OK){
+		//Back in the schedule from now on, the periods while degraded are not counted as missed
+		theEntry->mNextDue = theNow;
+	}
+	this->mActive = -1;
+	INA226_Bus_Poll(this);
+}
+//----------------------------------------------------------------------------
+//Snapshot: moves mSnapshotIndex past the devices left out, to the harvest after the last trigger.
+//mSnapshotIndex == mCount when harvesting means the harvest is complete, when restoring that the
+//snapshot is complete.
+static void INA226_Bus_SnapshotSkip(INA226_Bus* this)
+{
+	if(this->mSnapshotState == SnapshotTriggering){
+		while(this->mSnapshotIndex < this->mCount && this->mEntries[this->mSnapshotIndex].mDevice->Config.mDegraded){
+			this->mSnapshotIndex++;
+		}
+		if(this->mSnapshotIndex == this->mCount){
+			this->mSnapshotState = SnapshotHarvesting;
+			this->mSnapshotIndex = 0;
+		}
+	}
+	if(this->mSnapshotState == SnapshotHarvesting || this->mSnapshotState == SnapshotRestoring){
+		while(this->mSnapshotIndex < this->mCount && !this->mEntries[this->mSnapshotIndex].mInSnapshot){
+			this->mSnapshotIndex++;
+		}
+	}
+}
+
+//Next device to trigger or to read, -1 if the next result isn't ready yet
+static int8_t INA226_Bus_SnapshotNext(INA226_Bus* this, uint32_t aNow)
+{
+	INA226_Bus_SnapshotSkip(this);
+	if(this->mSnapshotIndex == this->mCount){
+		return -1;
+	}
+	if(this->mSnapshotState == SnapshotHarvesting && !INA226_Bus_IsDue(aNow, this->mEntries[this->mSnapshotIndex].mReady)){
+		return -1;
+	}
+	return (int8_t)this->mSnapshotIndex;
+}
+
+//End of the harvest (or a failure): the triggered devices get their configuration back first
+static void INA226_Bus_SnapshotFinish(INA226_Bus* this, status aStatus)
+{
+	this->mSnapshotStatus = aStatus;
+	this->mSnapshotState = SnapshotRestoring;
+	this->mSnapshotIndex = 0;
+	this->mActive = -1;
+	INA226_Bus_Poll(this);
+}
+
+static void INA226_Bus_SnapshotComplete(INA226_Bus* this)
+{
+	this->mSnapshotState = SnapshotIdle;
+	this->mActive = -1;
+	if(this->mOnSnapshot != NULL){
+		this->mOnSnapshot(this, this->mSnapshotStatus);
+	}
+	INA226_Bus_Poll(this);
+}
+
+static void INA226_Bus_SnapshotRestored(INA226* aDevice, status aStatus)
+{
+	INA226_Bus* this = aDevice->Async.mBus;
+	INA226_bus_entry* theEntry = &this->mEntries[(uint8_t)this->mActive];
+
+	this->mBusyTime_us += this->mClock() - this->mTransferStart;
+	if(aStatus != OK){
+		//Still triggered, the other devices are restored anyway
+		theEntry->mErrors++;
+		if(this->mSnapshotStatus == OK){
+			this->mSnapshotStatus = aStatus;
+		}
+	}
+	theEntry->mInSnapshot = false;
+	this->mSnapshotIndex++;
+	this->mActive = -1;
+	INA226_Bus_Poll(this);
+}
+
+static void INA226_Bus_SnapshotRead(INA226* aDevice, status aStatus)
+{
+	INA226_Bus* this = aDevice->Async.mBus;
+	INA226_bus_entry* theEntry = &this->mEntries[(uint8_t)this->mActive];
+
+	this->mBusyTime_us += this->mClock() - this->mTransferStart;
+	if(aStatus != OK){
+		theEntry->mErrors++;
+		INA226_Bus_SnapshotFinish(this, aStatus);
+		return;
+	}
+	theEntry->mSamples++;
+	aDevice->Result.Timestamp = theEntry->mTriggered + INA226_GetConversionPeriod_us(&aDevice->Config) / 2;
+	this->mSnapshotIndex++;
+	this->mActive = -1;
+	INA226_Bus_SnapshotSkip(this);
+	if(this->mSnapshotIndex == this->mCount){
+		INA226_Bus_SnapshotFinish(this, OK);
+		return;
+	}
+	INA226_Bus_Poll(this);
+}
+
+static void INA226_Bus_SnapshotTriggered(INA226* aDevice, status aStatus)
+{
+	INA226_Bus* this = aDevice->Async.mBus;
+	INA226_bus_entry* theEntry = &this->mEntries[(uint8_t)this->mActive];
+	uint32_t theNow = this->mClock();
+
+	this->mBusyTime_us += theNow - this->mTransferStart;
+	if(aStatus != OK){
+		theEntry->mErrors++;
+		INA226_Bus_SnapshotFinish(this, aStatus);
+		return;
+	}
+	//The conversion started with the end of the write, +10% for the oscillator tolerance
+	uint32_t thePeriod = INA226_GetConversionPeriod_us(&aDevice->Config);
+	theEntry->mInSnapshot = true;
+	theEntry->mTriggered = theNow;
+	theEntry->mReady = theNow + thePeriod + thePeriod / 10;
+	this->mSnapshotIndex++;
+	this->mActive = -1;
+	//Trigger the next device right away to keep the skew small
+	INA226_Bus_Poll(this);
+}
+
+static status INA226_Bus_SnapshotStep(INA226_Bus* this, INA226_bus_entry* aEntry)
+{
+	static const uint8_t cConfigRegister = INA226_CONFIG_REG;
+	INA226* theDevice = aEntry->mDevice;
+	if(this->mSnapshotState == SnapshotTriggering){
+		aEntry->mSavedConfig = theDevice->Config.mConfigRegister;
+		uint16_t theConfig = (theDevice->Config.mConfigRegister & ~cOperatingModeBits) | (uint16_t)ShuntAndBusTriggered;
+		return INA226_WriteRegistersAsync(theDevice, &cConfigRegister, &theConfig, 1, INA226_Bus_SnapshotTriggered);
+	}
+	if(this->mSnapshotState == SnapshotRestoring){
+		return INA226_WriteRegistersAsync(theDevice, &cConfigRegister, &aEntry->mSavedConfig, 1, INA226_Bus_SnapshotRestored);
+	}
+	return INA226_MeasureAsync(theDevice, this->mSnapshotSelection, INA226_Bus_SnapshotRead);
+}
+//----------------------------------------------------------------------------
+status INA226_Bus_StartSnapshot(INA226_Bus* this, uint8_t aSelection, INA226_SnapshotCallback aOnComplete)
+{
+	if(aSelection == 0 || (aSelection & ~MeasureEverything) != 0){
+		return BAD_PARAMETER;
+	}
+	INA226_BUS_ENTER_CRITICAL();
+	if(this->mSnapshotState != SnapshotIdle){
+		INA226_BUS_EXIT_CRITICAL();
+		return INA226_BUSY;
+	}
+	this->mSnapshotSelection = aSelection;
+	this->mOnSnapshot = aOnComplete;
+	this->mSnapshotIndex = 0;
+	this->mSnapshotState = SnapshotTriggering;
+	INA226_BUS_EXIT_CRITICAL();
+	//Starts now, or when the periodic sample on the bus completes
+	status s = INA226_Bus_Poll(this);
+	return s == INA226_BUSY ? OK : s;
+}
+//----------------------------------------------------------------------------
+bool INA226_Bus_SnapshotIsBusy(INA226_Bus* this)
+{
+	return this->mSnapshotState != SnapshotIdle;
+}
+//----------------------------------------------------------------------------
+status INA226_Bus_Poll(INA226_Bus* this)
+{
+	INA226_BUS_ENTER_CRITICAL();
+	if(this->mActive >= 0 || this->mCount == 0){
+		INA226_BUS_EXIT_CRITICAL();
+		return INA226_BUSY;
+	}
+	uint32_t theNow = this->mClock();
+	bool theSnapshot = this->mSnapshotState != SnapshotIdle;
+	int8_t theIndex = theSnapshot ? INA226_Bus_SnapshotNext(this, theNow) : INA226_Bus_SelectNext(this, theNow);
+	if(theIndex < 0){
+		bool theSnapshotDone = theSnapshot && this->mSnapshotIndex == this->mCount;
+		bool theRestored = this->mSnapshotState == SnapshotRestoring;
+		INA226_BUS_EXIT_CRITICAL();
+		if(theSnapshotDone && theRestored){
+			INA226_Bus_SnapshotComplete(this);
+		}else if(theSnapshotDone){
+			INA226_Bus_SnapshotFinish(this, OK); //every device was left out
+		}
+		return OK; //nothing to do yet
+	}
+	this->mActive = theIndex;
+	INA226_BUS_EXIT_CRITICAL();
+
+	INA226_bus_entry* theEntry = &this->mEntries[theIndex];
+	if(theSnapshot){
+		this->mTransferStart = theNow;
+		status s = INA226_Bus_SnapshotStep(this, theEntry);
+		if(s != OK && this->mSnapshotState == SnapshotRestoring){
+			INA226_Bus_SnapshotRestored(theEntry->mDevice, s);
+		}else if(s != OK){
+			theEntry->mErrors++;
+			INA226_Bus_SnapshotFinish(this, s);
+		}
+		return s;
+	}
+	this->mLastServed = theIndex;
+	if(theEntry->mDevice->Config.mDegraded){
+		theEntry->mReprobeDue = theNow + this->mReprobePeriod_us;
+		theEntry->mReprobes++;
+		this->mTransferStart = theNow;
+		status s = INA226_ReprobeAsync(theEntry->mDevice, INA226_Bus_DeviceReprobed);
+		if(s != OK){
+			this->mActive = -1;
+		}
+		return s;
+	}
+	//Advance by whole periods so the sample period doesn't drift with the bus load,
+	//periods that have already passed are counted as missed.
+	theEntry->mNextDue += theEntry->mPeriod_us;
+	while(INA226_Bus_IsDue(theNow, theEntry->mNextDue)){
+		theEntry->mNextDue += theEntry->mPeriod_us;
+		theEntry->mMissed++;
+	}
+
+	this->mTransferStart = theNow;
+	status s = INA226_MeasureAsync(theEntry->mDevice, theEntry->mSelection, INA226_Bus_DeviceComplete);
+	if(s != OK){
+		theEntry->mErrors++;
+		this->mActive = -1;
+	}
+	return s;
+}
+//----------------------------------------------------------------------------
+void INA226_Bus_TransferComplete(INA226_Bus* this)
+{
+	int8_t theIndex = this->mActive;
+	if(theIndex >= 0){
+		INA226_AsyncTransferComplete(this->mEntries[theIndex].mDevice);
+	}
+}
+//----------------------------------------------------------------------------
+void INA226_Bus_TransferError(INA226_Bus* this)
+{
+	int8_t theIndex = this->mActive;
+	if(theIndex >= 0){
+		INA226_AsyncTransferError(this->mEntries[theIndex].mDevice);
+	}
+}
+//----------------------------------------------------------------------------
+uint32_t INA226_Bus_GetUtilisation_permille(INA226_Bus* this)
+{
+	uint32_t theElapsed = this->mClock() - this->mStatisticsStart;
+	if(theElapsed == 0){
+		return 0;
+	}
+	return (uint32_t)(((uint64_t)this->mBusyTime_us * 1000u) / theElapsed);
+}
+//----------------------------------------------------------------------------
+void INA226_Bus_ResetStatistics(INA226_Bus* this)
+{
+	this->mBusyTime_us = 0;
+	this->mStatisticsStart = this->mClock != NULL ? this->mClock() : 0;
+}
@@ -0,0 +1,103 @@
+/*
+ * INA226_bus.h
+ *
+ * Scheduler for several INA226 devices sharing one I2C peripheral.
+ * The INA226_Bus owns the devices, keeps one non-blocking transfer sequence on the bus
+ * at a time and picks the next device by due time, priority and round-robin, so every
+ * channel gets its own deterministic sample period and the bus is kept busy.
+ */
+
+#ifndef INA226_INA226_BUS_H_
+#define INA226_INA226_BUS_H_
+
+#include "INA226.h"
+
+#define INA226_BUS_MAX_DEVICES	16 //INA226_ADRESS_0 .. INA226_ADRESS_15
+#define INA226_BUS_REPROBE_PERIOD_US	1000000 //degraded devices are re-probed this often by default
+
+//Protects the "is the bus idle" decision when INA226_Bus_Poll is called from a task while the
+//I2C interrupt may complete a transfer. Define them (e.g. __disable_irq/__enable_irq) if needed.
+#ifndef INA226_BUS_ENTER_CRITICAL
+#define INA226_BUS_ENTER_CRITICAL()
+#define INA226_BUS_EXIT_CRITICAL()
+#endif
+
+struct INA226_Bus;
+
+//Called from interrupt context after a device of the bus finished (or failed) a sample
+typedef void (*INA226_BusCallback)(struct INA226_Bus* this, uint8_t aDeviceIndex, status aStatus);
+//Called from interrupt context when every device of a snapshot has been read (or one failed)
+typedef void (*INA226_SnapshotCallback)(struct INA226_Bus* this, status aStatus);
+
+typedef struct INA226_bus_entry{
+	INA226*		mDevice;
+	uint32_t	mPeriod_us;		//sample period of this device
+	uint32_t	mNextDue;		//clock time of the next sample
+	uint8_t		mPriority;		//the higher the sooner, when several devices are due
+	uint8_t		mSelection;		//eMeasureSelect flags read for each sample
+	uint32_t	mSamples;
+	uint32_t	mMissed;		//periods skipped because the bus was too busy
+	uint32_t	mErrors;
+	uint32_t	mReprobeDue;	//clock time of the next re-probe while the device is degraded
+	uint32_t	mReprobes;
+	bool		mInSnapshot;	//triggered by the snapshot in progress, until its configuration is restored
+	uint16_t	mSavedConfig;	//configuration register before the snapshot
+	uint32_t	mTriggered;		//clock time the snapshot conversion started
+	uint32_t	mReady;			//clock time the snapshot result can be read
+} INA226_bus_entry;
+
+typedef struct INA226_Bus{
+	INA226_bus_entry	mEntries[INA226_BUS_MAX_DEVICES];
+	uint8_t				mCount;
+	volatile int8_t		mActive;		//index of the device on the bus, -1 if idle
+	uint8_t				mLastServed;	//round-robin position
+	INA226_ClockFn		mClock;
+	INA226_BusCallback	mOnSample;		//may be NULL
+	uint32_t			mReprobePeriod_us;	//INA226_BUS_REPROBE_PERIOD_US by default
+	//Snapshot, see INA226_Bus_StartSnapshot
+	volatile uint8_t		mSnapshotState;
+	uint8_t					mSnapshotIndex;
+	uint8_t					mSnapshotSelection;
+	status					mSnapshotStatus;	//of the harvest, passed to mOnSnapshot after the restore
+	INA226_SnapshotCallback	mOnSnapshot;
+	//Statistics for the bus utilisation
+	uint32_t			mTransferStart;
+	uint32_t			mBusyTime_us;
+	uint32_t			mStatisticsStart;
+} INA226_Bus;
+
+//aClock is mandatory, it provides the time base of the sample periods
+status		INA226_Bus_Init(INA226_Bus* this, INA226_ClockFn aClock, INA226_BusCallback aOnSample);
+//The device must be initialized and use the transport of the shared peripheral.
+//Returns INA226_BUSY if it is already on a bus.
+//The new samples are found in aDevice->Result / aDevice->Raw and are also pushed to
+//aDevice->Acquisition.mRing if set.
+status		INA226_Bus_Add(INA226_Bus* this, INA226* aDevice, uint32_t aPeriod_us, uint8_t aPriority, uint8_t aSelection);
+
+//Devices degraded by their failure policy (INA226_SetFailurePolicy) are skipped and only re-probed
+//(INA226_ReprobeAsync) every mReprobePeriod_us, so they don't cost bus time every period.
+//Starts the next due device if the bus is idle. Call it periodically (timer or main loop),
+//it is also called from the transfer complete interrupt to keep the bus busy.
+status		INA226_Bus_Poll(INA226_Bus* this);
+
+//Measures every device of the bus at (nearly) the same instant: the configuration registers are
+//written back to back in ShuntAndBusTriggered mode (each write starts a conversion), then every
+//device is read once its conversion is done, in the same order. Then each triggered device gets its
+//previous configuration register back (also after a failure), so the periodic sampling, paused
+//meanwhile, continues in the previous operating mode. aOnComplete gets the first error of the
+//harvest or of the restore. The results are in each device's Result / Raw, Result.Timestamp is the midpoint
+//of its conversion (bus clock) and mEntries[i].mTriggered the trigger time, the skew between the
+//first and last device is one register write per device. Degraded devices are skipped.
+//The INA226 only knows the reset command on the general call address, so there is no broadcast trigger.
+status		INA226_Bus_StartSnapshot(INA226_Bus* this, uint8_t aSelection, INA226_SnapshotCallback aOnComplete);
+bool		INA226_Bus_SnapshotIsBusy(INA226_Bus* this);
+
+//Call these from the I2C/DMA completion and error interrupts of the peripheral of the bus
+void		INA226_Bus_TransferComplete(INA226_Bus* this);
+void		INA226_Bus_TransferError(INA226_Bus* this);
+
+//Bus busy time since the last reset, in 1/1000 of the elapsed time
+uint32_t	INA226_Bus_GetUtilisation_permille(INA226_Bus* this);
+void		INA226_Bus_ResetStatistics(INA226_Bus* this);
+
+#endif /* INA226_INA226_BUS_H_ */
@@ -9,12 +9,14 @@
 //↑↑↑↑ --------------------------------- ↑↑↑↑
 
 #include "INA226.h"
+#include "INA226_callback.h"
+#include <stddef.h>
 
 int Transmit(INA226_config* this, uint8_t* aRegister, uint16_t Size){
 //----------------------------------------------------------------------------------------------------------------------------------------
 //↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓ Need to provide your own function  ↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓
 //
-	return HAL_I2C_Master_Transmit(this->hi2c, (uint16_t) this->mI2C_Address<<1, aRegister, Size, INA226_I2C_TIMEOUT);
+	return HAL_I2C_Master_Transmit(this->hi2c, (uint16_t) this->mI2C_Address<<1, aRegister, Size, this->mI2C_Timeout);
 //
 //↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑
 //----------------------------------------------------------------------------------------------------------------------------------------
@@ -24,7 +26,17 @@ int Receive(INA226_config* this, uint8_t* buffer, uint16_t Size){
 //----------------------------------------------------------------------------------------------------------------------------------------
 //↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓ Need to provide your own function  ↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓
 //
-	return HAL_I2C_Master_Receive(this->hi2c, (uint16_t) this->mI2C_Address<<1,	buffer, Size, INA226_I2C_TIMEOUT);
+	return HAL_I2C_Master_Receive(this->hi2c, (uint16_t) this->mI2C_Address<<1,	buffer, Size, this->mI2C_Timeout);
+//
+//↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑
+//----------------------------------------------------------------------------------------------------------------------------------------
+}
+
+int WriteRead(INA226_config* this, uint8_t aRegister, uint8_t* buffer, uint16_t Size){
+//----------------------------------------------------------------------------------------------------------------------------------------
+//↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓ Need to provide your own function  ↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓
+//
+	return HAL_I2C_Mem_Read(this->hi2c, (uint16_t) this->mI2C_Address<<1, aRegister, I2C_MEMADD_SIZE_8BIT, buffer, Size, this->mI2C_Timeout);
 //
 //↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑
 //----------------------------------------------------------------------------------------------------------------------------------------
@@ -34,8 +46,49 @@ int Check_device(INA226_config* this, uint8_t aI2C_Address , uint32_t Trials){
 //----------------------------------------------------------------------------------------------------------------------------------------
 //↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓ Need to provide your own function  ↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓
 //NOT MANDATORY, JUST RETURN 0
-	return HAL_I2C_IsDeviceReady(this->hi2c, (uint16_t)aI2C_Address<<1, Trials, INA226_I2C_TIMEOUT);
+	return HAL_I2C_IsDeviceReady(this->hi2c, (uint16_t)aI2C_Address<<1, Trials, this->mI2C_Timeout);
+//
+//↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑
+//----------------------------------------------------------------------------------------------------------------------------------------
+}
+
+int Transmit_Async(INA226_config* this, uint8_t* aData, uint16_t Size){
+//----------------------------------------------------------------------------------------------------------------------------------------
+//↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓ Need to provide your own function  ↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓
+//Completion: HAL_I2C_MasterTxCpltCallback
+	return HAL_I2C_Master_Transmit_DMA(this->hi2c, (uint16_t) this->mI2C_Address<<1, aData, Size);
 //
 //↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑
 //----------------------------------------------------------------------------------------------------------------------------------------
 }
+
+int Receive_Async(INA226_config* this, uint8_t* buffer, uint16_t Size){
+//----------------------------------------------------------------------------------------------------------------------------------------
+//↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓ Need to provide your own function  ↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓
+//Completion: HAL_I2C_MasterRxCpltCallback
+	return HAL_I2C_Master_Receive_DMA(this->hi2c, (uint16_t) this->mI2C_Address<<1, buffer, Size);
+//
+//↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑
+//----------------------------------------------------------------------------------------------------------------------------------------
+}
+
+int ReadRegister_Async(INA226_config* this, uint8_t aRegister, uint8_t* buffer, uint16_t Size){
+//----------------------------------------------------------------------------------------------------------------------------------------
+//↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓ Need to provide your own function  ↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓↓
+//Completion: HAL_I2C_MemRxCpltCallback
+	return HAL_I2C_Mem_Read_DMA(this->hi2c, (uint16_t) this->mI2C_Address<<1, aRegister, I2C_MEMADD_SIZE_8BIT, buffer, Size);
+//
+//↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑↑
+//----------------------------------------------------------------------------------------------------------------------------------------
+}
+
+const INA226_transport INA226_DefaultTransport = {
+	.Transmit			= Transmit,
+	.Receive			= Receive,
+	.WriteRead			= WriteRead,
+	.Check_device		= Check_device,
+	.Transmit_Async		= Transmit_Async,
+	.Receive_Async		= Receive_Async,
+	.ReadRegister_Async	= ReadRegister_Async,
+	.Context			= NULL,
+};
@@ -8,8 +8,22 @@
 #ifndef INA226_INA226_CALLBACK_H_
 #define INA226_INA226_CALLBACK_H_
 
+//Transport used by INA226_Init, built from the functions below.
+//Assign your own INA226_transport with INA226_InitWithTransport to use other busses/strategies.
+extern const INA226_transport INA226_DefaultTransport;
+
 int Transmit(INA226_config* this, uint8_t* aRegister, uint16_t Size);
 int Receive(INA226_config* this, uint8_t* buffer, uint16_t Size);
 int Check_device(INA226_config* this, uint8_t aI2C_Address , uint32_t Trials);
+//Pointer write and read with a repeated START (one bus transaction). If your bus/driver can't do
+//this, set WriteRead to NULL in the transport and the driver falls back to Transmit + Receive.
+int WriteRead(INA226_config* this, uint8_t aRegister, uint8_t* buffer, uint16_t Size);
+
+//Non-blocking transfers, used by the INA226_...Async functions. They only start the transfer,
+//completion must be reported by calling INA226_AsyncTransferComplete / INA226_AsyncTransferError.
+//The buffers passed in stay valid until then.
+int Transmit_Async(INA226_config* this, uint8_t* aData, uint16_t Size);
+int Receive_Async(INA226_config* this, uint8_t* buffer, uint16_t Size);
+int ReadRegister_Async(INA226_config* this, uint8_t aRegister, uint8_t* buffer, uint16_t Size);
 
 #endif /* INA226_INA226_CALLBACK_H_ */
@@ -0,0 +1,255 @@
+/*
+ * INA226_capture.c
+ *
+ * Continuous double buffered capture of one result register, see INA226_capture.h
+ */
+
+#include "INA226_capture.h"
+#include "INA226_internal.h"
+#include "INA226_ring.h"
+#include <stddef.h>
+
+enum eCapturePhase {CapturePhaseIdle = 0,
+                    CapturePhaseFlags = 1,	//MASK_ENABLE read, releases the ALERT pin
+                    CapturePhaseData = 2};
+
+static const uint16_t cOperatingModeBits = 0x0007;
+static const uint8_t  cAlertRetries      = 3; //failed reads in a row retried from the error interrupt
+
+//The DMA stores the registers MSB first, one pass over the half puts them in CPU order
+static void INA226_Capture_Swap(int16_t* aSamples, uint16_t aCount)
+{
+	uint16_t* theWords = (uint16_t*)aSamples;
+	for(uint16_t i = 0; i < aCount; i++){
+		theWords[i] = (uint16_t)(theWords[i] << 8 | theWords[i] >> 8);
+	}
+}
+
+static void INA226_Capture_Deliver(INA226_capture* this, uint16_t aEnd)
+{
+	uint16_t theCount = aEnd - this->mHalfStart;
+	if(theCount == 0){
+		return;
+	}
+	int16_t* theSamples = &this->mBuffer[this->mHalfStart];
+	INA226_Capture_Swap(theSamples, theCount);
+	this->mTimestamp = this->mHalfTimestamp;
+	INA226_CaptureCallback theCallback = this->mHalfStart == 0 ? this->mOnHalf : this->mOnFull;
+	if(theCallback != NULL){
+		theCallback(this, theSamples, theCount);
+	}
+}
+
+//Through the bus wrappers of the driver: counted, traced and subject to the failure policy
+static int INA226_Capture_StartRead(INA226_capture* this)
+{
+	INA226_config* theConfig = &this->mDevice->Config;
+	if(theConfig->mDegraded){
+		return -1; //skipped until the device is re-probed
+	}
+	if(this->mPacing == CapturePacedByTimer){
+		//The pointer stays on mRegister, no pointer write
+		this->mPhase = CapturePhaseData;
+		return INA226_BusReceiveAsync(theConfig, (uint8_t*)&this->mBuffer[this->mIndex], 2);
+	}
+	if(this->mPhase == CapturePhaseIdle){
+		this->mPhase = CapturePhaseFlags;
+		return INA226_BusReadRegisterAsync(theConfig, INA226_MASK_ENABLE_REG, this->mFlags, 2);
+	}
+	this->mPhase = CapturePhaseData;
+	return INA226_BusReadRegisterAsync(theConfig, this->mRegister, (uint8_t*)&this->mBuffer[this->mIndex], 2);
+}
+
+static void INA226_Capture_ReadFailed(INA226_capture* this)
+{
+	this->mPhase = CapturePhaseIdle;
+	this->mErrors++;
+	INA226_AccountAccess(&this->mDevice->Config, FAIL);
+	if(this->mPacing == CapturePacedByConversionReady){
+		//MASK_ENABLE may not have been read, the pin stays asserted until it is
+		this->mFailures++;
+		this->mAlertPending = true;
+	}
+}
+
+static void INA226_Capture_Pace(INA226_capture* this)
+{
+	if(!this->mRunning){
+		return;
+	}
+	if(this->mPhase != CapturePhaseIdle){
+		this->mOverruns++;
+		if(this->mPacing == CapturePacedByConversionReady){
+			//No further edge until MASK_ENABLE is read, that is done after the running read
+			this->mAlertPending = true;
+		}
+		return;
+	}
+	this->mAlertPending = false;
+	INA226_ClockFn theClock = this->mDevice->Acquisition.mClock;
+	if(this->mIndex == this->mHalfStart && theClock != NULL){
+		//Same correction as the driver: the conversion just signalled ended now, with a timer the
+		//latest one ended on average half a period ago
+		uint32_t theAge = this->mPacing == CapturePacedByTimer ? this->mPeriod_us : this->mPeriod_us / 2;
+		this->mHalfTimestamp = theClock() - theAge;
+	}
+	if(INA226_Capture_StartRead(this) != 0){
+		INA226_Capture_ReadFailed(this);
+	}
+}
+
+//Reads the conversion of an ALERT edge that came during a read or whose read failed
+static void INA226_Capture_Resume(INA226_capture* this, bool aRetryFailed)
+{
+	if(!this->mAlertPending || this->mPhase != CapturePhaseIdle){
+		return;
+	}
+	if(!aRetryFailed && this->mFailures >= cAlertRetries){
+		return;
+	}
+	INA226_Capture_Pace(this);
+}
+//----------------------------------------------------------------------------
+status INA226_Capture_Start(INA226_capture* this, INA226* aDevice, uint8_t aRegister, enum eCapturePacing aPacing,
+						   int16_t* aBuffer, uint16_t aLength, INA226_CaptureCallback aOnHalf, INA226_CaptureCallback aOnFull,
+						   uint32_t* aPeriod_us_p)
+{
+	if(aBuffer == NULL || aLength < 2 || (aLength & 1) ||
+	   (aRegister != INA226_SHUNT_VOLTAGE_REG && aRegister != INA226_CURRENT_REG)){
+		return BAD_PARAMETER;
+	}
+	if(!aDevice->Config.mInitialized){
+		return NOT_INITIALIZED;
+	}
+	const INA226_transport* theTransport = aDevice->Config.mTransport;
+	if((aPacing == CapturePacedByTimer && theTransport->Receive_Async == NULL) ||
+	   (aPacing == CapturePacedByConversionReady && theTransport->ReadRegister_Async == NULL)){
+		return BAD_PARAMETER;
+	}
+	//Both registers follow the shunt conversions
+	if((aDevice->Config.mConfigRegister & cOperatingModeBits & ShuntVoltageContinuous) != ShuntVoltageContinuous){
+		return CONFIG_ERROR;
+	}
+	if(aDevice->Async.mState != AsyncIdle){
+		return INA226_BUSY;
+	}
+
+	this->mDevice = aDevice;
+	this->mBuffer = aBuffer;
+	this->mHalfLength = aLength / 2;
+	this->mIndex = 0;
+	this->mHalfStart = 0;
+	this->mRegister = aRegister;
+	this->mPacing = aPacing;
+	this->mPhase = CapturePhaseIdle;
+	this->mRunning = false;
+	this->mOnHalf = aOnHalf;
+	this->mOnFull = aOnFull;
+	this->mSamples = 0;
+	this->mOverruns = 0;
+	this->mErrors = 0;
+	this->mAlertPending = false;
+	this->mFailures = 0;
+	this->mPeriod_us = INA226_GetConversionPeriod_us(&aDevice->Config);
+	this->mHalfTimestamp = 0;
+	this->mTimestamp = 0;
+
+	if(aPacing == CapturePacedByTimer){
+		//The one pointer write of the whole capture
+		CALL_FN( INA226_SetRegisterPointer(&aDevice->Config, aRegister) );
+	}else{
+		CALL_FN( INA226_ConfigureAlertPinTrigger(&aDevice->Config, ConversionReady, 0, false) );
+	}
+	if(aPeriod_us_p != NULL){
+		*aPeriod_us_p = this->mPeriod_us;
+	}
+	//Keeps the other non-blocking users off the device
+	aDevice->Async.mState = AsyncBusy;
+	INA226_MEMORY_BARRIER();
+	this->mRunning = true;
+	return OK;
+}
+//----------------------------------------------------------------------------
+status INA226_Capture_Stop(INA226_capture* this)
+{
+	this->mRunning = false;
+	INA226_MEMORY_BARRIER();
+	if(this->mPhase != CapturePhaseIdle){
+		return INA226_BUSY;
+	}
+	if(this->mDevice->Async.mState == AsyncIdle){
+		return OK; //already stopped
+	}
+	INA226_Capture_Deliver(this, this->mIndex);
+	this->mHalfStart = this->mIndex;
+	this->mDevice->Async.mState = AsyncIdle;
+	if(this->mPacing == CapturePacedByConversionReady){
+		this->mDevice->Config.mRegisterPointerValid = false;
+		return INA226_ConfigureAlertPinTrigger(&this->mDevice->Config, ClearTriggers, 0, false);
+	}
+	return OK;
+}
+//----------------------------------------------------------------------------
+void INA226_Capture_Tick(INA226_capture* this)
+{
+	INA226_Capture_Pace(this);
+}
+//----------------------------------------------------------------------------
+void INA226_Capture_AlertISR(INA226_capture* this)
+{
+	INA226_Capture_Pace(this);
+}
+//----------------------------------------------------------------------------
+void INA226_Capture_TransferComplete(INA226_capture* this)
+{
+	if(this->mPhase == CapturePhaseIdle){
+		return;
+	}
+	INA226_config* theConfig = &this->mDevice->Config;
+	INA226_BusAsyncEnd(theConfig, 0);
+	INA226_AccountAccess(theConfig, OK);
+	if(this->mPhase == CapturePhaseFlags){
+		if(!(this->mFlags[1] & ConversionReadyFlag)){
+			//No new conversion (INA226_Capture_Poll or a tick without an alert), no sample
+			this->mFailures = 0;
+			this->mPhase = CapturePhaseIdle;
+			INA226_Capture_Resume(this, false);
+			return;
+		}
+		//Pin released, now the sample
+		if(INA226_Capture_StartRead(this) != 0){
+			INA226_Capture_ReadFailed(this);
+			INA226_Capture_Resume(this, false);
+		}
+		return;
+	}
+	uint16_t theIndex = this->mIndex + 1;
+	this->mSamples++;
+	if(theIndex == this->mHalfLength || theIndex == 2 * this->mHalfLength){
+		INA226_Capture_Deliver(this, theIndex);
+		if(theIndex == 2 * this->mHalfLength){
+			theIndex = 0;
+		}
+		this->mHalfStart = theIndex;
+	}
+	this->mIndex = theIndex;
+	this->mFailures = 0;
+	this->mPhase = CapturePhaseIdle;
+	INA226_Capture_Resume(this, false);
+}
+//----------------------------------------------------------------------------
+void INA226_Capture_TransferError(INA226_capture* this)
+{
+	if(this->mPhase == CapturePhaseIdle){
+		return;
+	}
+	//The slot is rewritten by the next read, a failed read doesn't move the pointer
+	INA226_BusAsyncEnd(&this->mDevice->Config, -1);
+	INA226_Capture_ReadFailed(this);
+	INA226_Capture_Resume(this, false);
+}
+//----------------------------------------------------------------------------
+void INA226_Capture_Poll(INA226_capture* this)
+{
+	INA226_Capture_Resume(this, true);
+}
@@ -0,0 +1,91 @@
+/*
+ * INA226_capture.h
+ *
+ * Continuous capture of one result register (shunt voltage or current) of one INA226 at the
+ * conversion rate, into a double buffer. Every sample is one non-blocking 2 byte read that the
+ * DMA writes straight into the buffer, the CPU only touches the data when a half is full:
+ * the half is converted from the bus byte order in one pass and handed to the callback while
+ * the other half is being filled.
+ *
+ * Pacing:
+ *  - CapturePacedByTimer: the register pointer is written once at start, then every
+ *    INA226_Capture_Tick (timer interrupt at the conversion period) is a single 2 byte read
+ *    without pointer write. Fastest, the timer and the INA226 oscillator (+-10%) are not
+ *    synchronized though, so a sample may be repeated or skipped now and then.
+ *  - CapturePacedByConversionReady: the ALERT pin signals every conversion, exactly one
+ *    sample per conversion as long as the bus keeps up. Releasing the pin needs a MASK_ENABLE
+ *    read, so each sample costs two register reads: about 250us at 400kHz, 100us at 1MHz.
+ *    Shorter conversion periods (e.g. 140us without averaging) need timer pacing (one 3 byte
+ *    read, about 75us at 400kHz) or a 1MHz bus: an edge during a read is counted in mOverruns
+ *    and that conversion is read right after it, the conversions in between are lost.
+ *    A failed read is retried from the error interrupt a few times; call INA226_Capture_Poll
+ *    from a slow timer if the bus can fail for longer, the pin stays asserted until it is read.
+ *
+ * The capture owns the device while it runs: the non-blocking functions of the device
+ * return INA226_BUSY and the blocking ones must not be used.
+ */
+
+#ifndef INA226_INA226_CAPTURE_H_
+#define INA226_INA226_CAPTURE_H_
+
+#include "INA226.h"
+
+enum eCapturePacing {CapturePacedByTimer = 0,
+                     CapturePacedByConversionReady = 1};
+
+struct INA226_capture;
+
+//Called from interrupt context with a completed half of the buffer (or the rest of the
+//current half when the capture is stopped). The samples are valid until the same half is
+//refilled, one buffer half duration later. this->mTimestamp is the midpoint of the conversion
+//window of aSamples[0] (see INA226_SetClock), the following ones are mPeriod_us apart.
+typedef void (*INA226_CaptureCallback)(struct INA226_capture* this, const int16_t* aSamples, uint16_t aCount);
+
+typedef struct INA226_capture{
+	INA226*					mDevice;
+	int16_t*				mBuffer;		//2 * mHalfLength samples, in bus byte order until the half is complete
+	uint16_t				mHalfLength;
+	volatile uint16_t		mIndex;			//next sample written
+	uint16_t				mHalfStart;		//first sample of the half being filled
+	uint8_t					mRegister;
+	uint8_t					mPacing;		//eCapturePacing
+	volatile uint8_t		mPhase;			//transfer in flight
+	volatile bool			mRunning;
+	uint8_t					mFlags[2];		//MASK_ENABLE, conversion ready pacing only
+	uint32_t				mPeriod_us;		//conversion period when the capture was started
+	uint32_t				mHalfTimestamp;	//first sample of the half being filled
+	uint32_t				mTimestamp;		//first sample of the half being delivered
+	INA226_CaptureCallback	mOnHalf;		//first half complete
+	INA226_CaptureCallback	mOnFull;		//second half complete, may be the same function
+	void*					mUserData;
+	uint32_t				mSamples;
+	uint32_t				mOverruns;		//pacing events while the previous read was still on the bus
+	volatile bool			mAlertPending;	//conversion ready pacing: ALERT not released yet (overrun or failed read)
+	uint8_t					mFailures;		//failed reads in a row
+	uint32_t				mErrors;		//failed reads, and reads skipped while the device is degraded
+} INA226_capture;
+
+//aRegister is INA226_SHUNT_VOLTAGE_REG or INA226_CURRENT_REG, aBuffer holds aLength samples
+//(even, the two halves). The device must be initialized, in a continuous mode, and its transport
+//must have Receive_Async (timer pacing) or ReadRegister_Async (conversion ready pacing).
+//The conversion period of the current configuration is returned in aPeriod_us_p (may be NULL),
+//program the timer with it for CapturePacedByTimer.
+status	INA226_Capture_Start(INA226_capture* this, INA226* aDevice, uint8_t aRegister, enum eCapturePacing aPacing,
+							 int16_t* aBuffer, uint16_t aLength, INA226_CaptureCallback aOnHalf, INA226_CaptureCallback aOnFull,
+							 uint32_t* aPeriod_us_p);
+//Stops starting new reads and delivers the samples of the current half. Returns INA226_BUSY
+//while the last read is still on the bus, call it again later.
+status	INA226_Capture_Stop(INA226_capture* this);
+
+//Pacing events: the timer interrupt (CapturePacedByTimer) or the EXTI interrupt of the
+//ALERT pin (CapturePacedByConversionReady)
+void	INA226_Capture_Tick(INA226_capture* this);
+void	INA226_Capture_AlertISR(INA226_capture* this);
+//Conversion ready pacing: restarts the read of a pending alert, nothing otherwise
+void	INA226_Capture_Poll(INA226_capture* this);
+
+//Call these from the I2C/DMA completion and error interrupts instead of INA226_AsyncTransferComplete
+void	INA226_Capture_TransferComplete(INA226_capture* this);
+void	INA226_Capture_TransferError(INA226_capture* this);
+
+#endif /* INA226_INA226_CAPTURE_H_ */
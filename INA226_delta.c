@@ -0,0 +1,241 @@
+/*
+ * INA226_delta.c
+ *
+ * Change-only delta encoding of raw samples, see INA226_delta.h
+ */
+
+#include "INA226_delta.h"
+#include <stddef.h>
+
+enum eVarintResult {VarintComplete = 0,
+                    VarintCut      = 1, //ends after aEnd, the rest comes with the next buffer
+                    VarintCorrupt  = 2};
+
+static const uint8_t cKeyFrame = 0x80;
+static const uint8_t cChannelMask = MeasureEverything;
+//eMeasureSelect flag of each register of INA226_raw, in register order
+static const uint8_t caChannelFlags[4] = {MeasureShuntVoltage, MeasureBusVoltage, MeasurePower, MeasureCurrent};
+
+//Registers of a sample as 32 bit values, so the differences can't overflow
+static void INA226_Delta_Values(const INA226_raw* aRaw, int32_t* aValues_p)
+{
+	aValues_p[0] = aRaw->ShuntVoltage;
+	aValues_p[1] = aRaw->BusVoltage;
+	aValues_p[2] = aRaw->Power;
+	aValues_p[3] = aRaw->Current;
+}
+
+static void INA226_Delta_SetValue(INA226_raw* aRaw, uint8_t aChannel, int32_t aValue)
+{
+	switch(aChannel){
+	case 0: aRaw->ShuntVoltage = (int16_t)aValue; break;
+	case 1: aRaw->BusVoltage = (uint16_t)aValue; break;
+	case 2: aRaw->Power = (uint16_t)aValue; break;
+	default: aRaw->Current = (int16_t)aValue; break;
+	}
+}
+
+static uint8_t* INA226_Delta_PutVarint(uint8_t* aOut, uint32_t aValue)
+{
+	while(aValue >= 0x80){
+		*aOut++ = (uint8_t)(aValue | 0x80);
+		aValue >>= 7;
+	}
+	*aOut++ = (uint8_t)aValue;
+	return aOut;
+}
+
+//Advances *aIn_p past the varint if it is complete. Corrupt: more than 5 bytes or more than 32 bits.
+static enum eVarintResult INA226_Delta_GetVarint(const uint8_t** aIn_p, const uint8_t* aEnd, uint32_t* aValue_p)
+{
+	const uint8_t* theIn = *aIn_p;
+	uint32_t theValue = 0;
+	for(uint8_t theShift = 0; theShift < 35; theShift += 7){
+		if(theIn == aEnd){
+			return VarintCut;
+		}
+		uint8_t theByte = *theIn++;
+		if(theShift == 28 && theByte > 0x0F){
+			return VarintCorrupt; //the 5th byte holds the top 4 bits and ends the varint
+		}
+		theValue |= (uint32_t)(theByte & 0x7F) << theShift;
+		if(!(theByte & 0x80)){
+			*aValue_p = theValue;
+			*aIn_p = theIn;
+			return VarintComplete;
+		}
+	}
+	return VarintCorrupt; //not reached
+}
+
+static uint32_t INA226_Delta_ZigZag(int32_t aValue)
+{
+	return ((uint32_t)aValue << 1) ^ (uint32_t)(aValue >> 31);
+}
+
+static int32_t INA226_Delta_UnZigZag(uint32_t aValue)
+{
+	return (int32_t)(aValue >> 1) ^ -(int32_t)(aValue & 1);
+}
+
+//Micro units to register LSBs, saturated to the 16 bit deadband
+static uint16_t INA226_Delta_Deadband(uint32_t aMicroUnits, uint32_t aNumerator, uint32_t aDenominator)
+{
+	if(aDenominator == 0){
+		return 0;
+	}
+	uint64_t theDeadband = (uint64_t)aMicroUnits * aNumerator / aDenominator;
+	return theDeadband > 0xFFFF ? 0xFFFF : (uint16_t)theDeadband;
+}
+//----------------------------------------------------------------------------
+status INA226_Delta_Init(INA226_delta* this, const INA226_config* aConfig, uint32_t aShuntVoltage_uV, uint32_t aBusVoltage_uV,
+						 uint32_t aPower_uW, uint32_t aCurrent_uA, uint32_t aMaxInterval_us)
+{
+	if(!aConfig->mInitialized){
+		return NOT_INITIALIZED;
+	}
+	this->mDeadband[0] = INA226_Delta_Deadband(aShuntVoltage_uV, 2, 5); //2.5uV per bit
+	this->mDeadband[1] = INA226_Delta_Deadband(aBusVoltage_uV, 1, INA226_BUS_VOLTAGE_LSB_UV);
+	this->mDeadband[2] = INA226_Delta_Deadband(aPower_uW, 1, (uint32_t)aConfig->mPowerMicroWattPerBit);
+	this->mDeadband[3] = INA226_Delta_Deadband(aCurrent_uA, 1, (uint32_t)aConfig->mCurrentMicroAmpsPerBit);
+	this->mMaxInterval_us = aMaxInterval_us;
+	this->mSamples = 0;
+	this->mRecords = 0;
+	INA226_Delta_Reset(this);
+	return OK;
+}
+//----------------------------------------------------------------------------
+void INA226_Delta_Reset(INA226_delta* this)
+{
+	this->mKeyPending = true;
+}
+//----------------------------------------------------------------------------
+uint32_t INA226_Delta_Encode(INA226_delta* this, const INA226_sample* aSamples, uint32_t aCount,
+							 uint8_t* aOut, uint32_t aOutSize, uint32_t* aConsumed_p)
+{
+	uint8_t* theOut = aOut;
+	uint8_t* const theLast = aOut + aOutSize; //one record must fit between theOut and theLast
+	uint32_t i = 0;
+	for(; i < aCount && theLast - theOut >= INA226_DELTA_MAX_RECORD; i++){
+		const INA226_sample* theSample = &aSamples[i];
+		int32_t theValues[4];
+		int32_t theReference[4];
+		INA226_Delta_Values(&theSample->Raw, theValues);
+		INA226_Delta_Values(&this->mReference.Raw, theReference);
+		this->mSamples++;
+
+		uint8_t theHeader;
+		uint32_t theElapsed;
+		if(this->mKeyPending){
+			theHeader = cKeyFrame | cChannelMask;
+			theElapsed = theSample->Timestamp;
+			for(uint8_t c = 0; c < 4; c++){
+				theReference[c] = 0;
+			}
+		}else{
+			theHeader = 0;
+			theElapsed = theSample->Timestamp - this->mReference.Timestamp;
+			uint8_t theChanged = 0;
+			for(uint8_t c = 0; c < 4; c++){
+				int32_t theDelta = theValues[c] - theReference[c];
+				if(theDelta != 0){
+					theChanged |= caChannelFlags[c];
+				}
+				if(theDelta > this->mDeadband[c] || -theDelta > this->mDeadband[c]){
+					theHeader |= caChannelFlags[c];
+				}
+			}
+			if(theHeader == 0){
+				if(this->mMaxInterval_us == 0 || theElapsed < this->mMaxInterval_us){
+					continue; //within the deadbands, nothing to report
+				}
+				//Heartbeat, brings every register in sync again (may be an empty record)
+				theHeader = theChanged;
+			}
+		}
+
+		*theOut++ = theHeader;
+		theOut = INA226_Delta_PutVarint(theOut, theElapsed);
+		for(uint8_t c = 0; c < 4; c++){
+			if(theHeader & caChannelFlags[c]){
+				theOut = INA226_Delta_PutVarint(theOut, INA226_Delta_ZigZag(theValues[c] - theReference[c]));
+				INA226_Delta_SetValue(&this->mReference.Raw, c, theValues[c]);
+			}
+		}
+		this->mReference.Timestamp = theSample->Timestamp;
+		this->mKeyPending = false;
+		this->mRecords++;
+	}
+	if(aConsumed_p != NULL){
+		*aConsumed_p = i;
+	}
+	return (uint32_t)(theOut - aOut);
+}
+//----------------------------------------------------------------------------
+void INA226_Delta_DecoderInit(INA226_delta_decoder* this)
+{
+	this->mSynced = false;
+	this->mCorrupt = 0;
+}
+//----------------------------------------------------------------------------
+uint32_t INA226_Delta_Decode(INA226_delta_decoder* this, const uint8_t* aIn, uint32_t aSize,
+							 INA226_sample* aSamples_p, uint32_t aMaxCount, uint32_t* aUsed_p)
+{
+	const uint8_t* theIn = aIn;
+	const uint8_t* const theEnd = aIn + aSize;
+	uint32_t theCount = 0;
+	while(theIn < theEnd && theCount < aMaxCount){
+		const uint8_t* theRecord = theIn;
+		uint8_t theHeader = *theIn++;
+		if(theHeader & ~(cKeyFrame | cChannelMask)){
+			//Corrupt: drop the byte, skip everything up to the next key frame
+			this->mCorrupt++;
+			this->mSynced = false;
+			continue;
+		}
+		INA226_sample theSample = this->mReference;
+		bool theKey = (theHeader & cKeyFrame) != 0;
+		if(theKey){
+			theSample.Timestamp = 0;
+			theSample.Raw.ShuntVoltage = 0;
+			theSample.Raw.BusVoltage = 0;
+			theSample.Raw.Power = 0;
+			theSample.Raw.Current = 0;
+		}
+		uint32_t theValue;
+		enum eVarintResult theResult = INA226_Delta_GetVarint(&theIn, theEnd, &theValue);
+		if(theResult == VarintComplete){
+			theSample.Timestamp += theValue;
+			int32_t theValues[4];
+			INA226_Delta_Values(&theSample.Raw, theValues);
+			for(uint8_t c = 0; c < 4 && theResult == VarintComplete; c++){
+				if(theHeader & caChannelFlags[c]){
+					theResult = INA226_Delta_GetVarint(&theIn, theEnd, &theValue);
+					INA226_Delta_SetValue(&theSample.Raw, c, theValues[c] + INA226_Delta_UnZigZag(theValue));
+				}
+			}
+		}
+		if(theResult == VarintCut){
+			theIn = theRecord; //cut at the end of aIn, decoded with the next buffer
+			break;
+		}
+		if(theResult == VarintCorrupt){
+			//Drop the header and look for a record in the bytes after it, up to the next key frame
+			this->mCorrupt++;
+			this->mSynced = false;
+			theIn = theRecord + 1;
+			continue;
+		}
+		if(theKey){
+			this->mSynced = true;
+		}
+		if(this->mSynced){
+			this->mReference = theSample;
+			aSamples_p[theCount++] = theSample;
+		}
+	}
+	if(aUsed_p != NULL){
+		*aUsed_p = (uint32_t)(theIn - aIn);
+	}
+	return theCount;
+}
@@ -0,0 +1,64 @@
+/*
+ * INA226_delta.h
+ *
+ * Change-only reporting of raw samples for narrow links (radio, CAN).
+ * A sample is only emitted when one of its registers moved past the deadband of that channel
+ * since the last emitted sample, or when mMaxInterval_us elapsed (heartbeat). Emitted samples
+ * are delta encoded against the last emitted one:
+ *   header    1 byte      bit 0..3: eMeasureSelect flags of the registers that follow,
+ *                         bit 7: key frame (the references are 0, the timestamp is absolute)
+ *   timestamp varint      microseconds since the previous record
+ *   registers zigzag varint of the difference to the previous value, for every flag set,
+ *             in register order (shunt, bus, power, current)
+ * A typical record is 3 - 5 bytes instead of the 12 of an INA226_sample. Registers that aren't
+ * in a record keep their previous value, so the decoded values are within the deadband of the
+ * real ones, and exact after every heartbeat.
+ */
+
+#ifndef INA226_INA226_DELTA_H_
+#define INA226_INA226_DELTA_H_
+
+#include "INA226.h"
+#include "INA226_ring.h"
+
+#define INA226_DELTA_MAX_RECORD	18 //header + 32 bit timestamp varint + 4 registers of 3 bytes
+
+typedef struct INA226_delta{
+	uint16_t		mDeadband[4];	//register LSBs, in INA226_raw order (shunt, bus, power, current)
+	uint32_t		mMaxInterval_us;
+	INA226_sample	mReference;		//last emitted sample, as the decoder knows it
+	bool			mKeyPending;	//next record is a key frame
+	uint32_t		mSamples;		//samples seen
+	uint32_t		mRecords;		//records emitted
+} INA226_delta;
+
+typedef struct INA226_delta_decoder{
+	INA226_sample	mReference;
+	bool			mSynced;		//a key frame was decoded, delta records before it are skipped
+	uint32_t		mCorrupt;		//corrupt records (bad header, overlong varint) dropped
+} INA226_delta_decoder;
+
+//Deadbands in micro units, scaled with the LSBs of aConfig (0: every change is reported).
+//aMaxInterval_us: a sample is emitted at least this often, 0 for never.
+status		INA226_Delta_Init(INA226_delta* this, const INA226_config* aConfig, uint32_t aShuntVoltage_uV, uint32_t aBusVoltage_uV,
+							  uint32_t aPower_uW, uint32_t aCurrent_uA, uint32_t aMaxInterval_us);
+//The next record is a key frame, e.g. after the link was lost
+void		INA226_Delta_Reset(INA226_delta* this);
+
+//Encodes the samples that need to be reported into aOut. Stops when aOut can't hold another
+//record (INA226_DELTA_MAX_RECORD). Returns the bytes written, *aConsumed_p (may be NULL) is the
+//number of samples processed, feed the rest again with a new buffer.
+uint32_t	INA226_Delta_Encode(INA226_delta* this, const INA226_sample* aSamples, uint32_t aCount,
+								uint8_t* aOut, uint32_t aOutSize, uint32_t* aConsumed_p);
+
+//Receiving side
+void		INA226_Delta_DecoderInit(INA226_delta_decoder* this);
+//Decodes the records of aIn into aSamples_p (at most aMaxCount), returns the number of samples.
+//*aUsed_p (may be NULL) is the number of bytes decoded, a record cut at the end of aIn is left
+//for the next call. A corrupt record is counted in mCorrupt and its header byte dropped, decoding
+//goes on with the following bytes but skips everything up to the next key frame (heartbeat, or
+//INA226_Delta_Reset on the sender).
+uint32_t	INA226_Delta_Decode(INA226_delta_decoder* this, const uint8_t* aIn, uint32_t aSize,
+								INA226_sample* aSamples_p, uint32_t aMaxCount, uint32_t* aUsed_p);
+
+#endif /* INA226_INA226_DELTA_H_ */
@@ -0,0 +1,252 @@
+/*
+ * INA226_dsp.c
+ *
+ * Batch statistics kernels over raw INA226 registers, see INA226_dsp.h
+ */
+
+#include "INA226_dsp.h"
+#include <string.h>
+
+#if !defined(INA226_DSP_SCALAR)
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define INA226_DSP_NEON
+#include <arm_neon.h>
+#elif defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define INA226_DSP_CMSIS
+#include "cmsis_compiler.h"
+#elif defined(__SSE2__) || defined(_M_X64)
+#define INA226_DSP_SSE2
+#include <emmintrin.h>
+#endif
+#endif
+
+//The 32 bit partial sums of the SIMD loops are flushed to 64 bit after this many 16 bit values,
+//|sum| <= 16384 * 2 * 32768 = 2^30 per lane then
+#define INA226_DSP_CHUNK	32768u
+
+//----------------------------------------------------------------------------
+//Portable loop, also used for the tails of the SIMD versions
+static void INA226_Dsp_Stats_s16_Scalar(const int16_t* aValues, uint32_t aCount, INA226_rawstats* aStats_p)
+{
+	for(uint32_t i = 0; i < aCount; i++){
+		int32_t theValue = aValues[i];
+		if(theValue < aStats_p->Min) aStats_p->Min = theValue;
+		if(theValue > aStats_p->Max) aStats_p->Max = theValue;
+		aStats_p->Sum += theValue;
+		aStats_p->SumOfSquares += (uint64_t)((int64_t)theValue * theValue);
+	}
+}
+
+#if defined(INA226_DSP_CMSIS)
+//Cortex-M4/M7: two values per 32 bit word, SMLAD for the sum, SMLALD for the squares,
+//SSUB16 + SEL for the packed min/max
+static uint32_t INA226_Dsp_Stats_s16_Simd(const int16_t* aValues, uint32_t aCount, INA226_rawstats* aStats_p)
+{
+	uint32_t thePairs = aCount / 2;
+	uint32_t theMin = 0x7FFF7FFFu;
+	uint32_t theMax = 0x80008000u;
+	uint64_t theSquares = 0;
+	uint32_t i = 0;
+	while(i < thePairs){
+		uint32_t theEnd = i + INA226_DSP_CHUNK / 2;
+		if(theEnd > thePairs){
+			theEnd = thePairs;
+		}
+		int32_t theSum = 0;
+		for(; i < theEnd; i++){
+			uint32_t theWord;
+			memcpy(&theWord, &aValues[2 * i], sizeof(theWord)); //LDR, unaligned access is fine on M4/M7
+			theSum = (int32_t)__SMLAD(theWord, 0x00010001u, (uint32_t)theSum);
+			theSquares = __SMLALD(theWord, theWord, theSquares);
+			__SSUB16(theWord, theMax);
+			theMax = __SEL(theWord, theMax);
+			__SSUB16(theWord, theMin);
+			theMin = __SEL(theMin, theWord);
+		}
+		aStats_p->Sum += theSum;
+	}
+	aStats_p->SumOfSquares += theSquares;
+	int32_t theLaneMin = (int16_t)(theMin & 0xFFFF) < (int16_t)(theMin >> 16) ? (int16_t)(theMin & 0xFFFF) : (int16_t)(theMin >> 16);
+	int32_t theLaneMax = (int16_t)(theMax & 0xFFFF) > (int16_t)(theMax >> 16) ? (int16_t)(theMax & 0xFFFF) : (int16_t)(theMax >> 16);
+	if(thePairs > 0){
+		if(theLaneMin < aStats_p->Min) aStats_p->Min = theLaneMin;
+		if(theLaneMax > aStats_p->Max) aStats_p->Max = theLaneMax;
+	}
+	return thePairs * 2;
+}
+#elif defined(INA226_DSP_NEON)
+//NEON: eight values per vector, pairwise add-accumulate for the sum, widening multiply for the squares
+static uint32_t INA226_Dsp_Stats_s16_Simd(const int16_t* aValues, uint32_t aCount, INA226_rawstats* aStats_p)
+{
+	uint32_t theVectors = aCount / 8;
+	int16x8_t theMin = vdupq_n_s16(INT16_MAX);
+	int16x8_t theMax = vdupq_n_s16(INT16_MIN);
+	uint64x2_t theSquares = vdupq_n_u64(0);
+	uint32_t i = 0;
+	while(i < theVectors){
+		uint32_t theEnd = i + INA226_DSP_CHUNK / 8;
+		if(theEnd > theVectors){
+			theEnd = theVectors;
+		}
+		int32x4_t theSum = vdupq_n_s32(0);
+		for(; i < theEnd; i++){
+			int16x8_t theValues = vld1q_s16(&aValues[8 * i]);
+			theMin = vminq_s16(theMin, theValues);
+			theMax = vmaxq_s16(theMax, theValues);
+			theSum = vpadalq_s16(theSum, theValues);
+			int32x4_t theLow = vmull_s16(vget_low_s16(theValues), vget_low_s16(theValues));
+			int32x4_t theHigh = vmull_s16(vget_high_s16(theValues), vget_high_s16(theValues));
+			theSquares = vpadalq_u32(theSquares, vreinterpretq_u32_s32(theLow));
+			theSquares = vpadalq_u32(theSquares, vreinterpretq_u32_s32(theHigh));
+		}
+		aStats_p->Sum += (int64_t)vgetq_lane_s32(theSum, 0) + vgetq_lane_s32(theSum, 1) +
+			vgetq_lane_s32(theSum, 2) + vgetq_lane_s32(theSum, 3);
+	}
+	aStats_p->SumOfSquares += vgetq_lane_u64(theSquares, 0) + vgetq_lane_u64(theSquares, 1);
+	if(theVectors > 0){
+		int16_t theLanes[8];
+		vst1q_s16(theLanes, theMin);
+		for(int k = 0; k < 8; k++) if(theLanes[k] < aStats_p->Min) aStats_p->Min = theLanes[k];
+		vst1q_s16(theLanes, theMax);
+		for(int k = 0; k < 8; k++) if(theLanes[k] > aStats_p->Max) aStats_p->Max = theLanes[k];
+	}
+	return theVectors * 8;
+}
+#elif defined(INA226_DSP_SSE2)
+//SSE2: eight values per vector, PMADDWD for both the sum (times 1) and the squares
+static uint32_t INA226_Dsp_Stats_s16_Simd(const int16_t* aValues, uint32_t aCount, INA226_rawstats* aStats_p)
+{
+	uint32_t theVectors = aCount / 8;
+	const __m128i theOnes = _mm_set1_epi16(1);
+	const __m128i theZero = _mm_setzero_si128();
+	__m128i theMin = _mm_set1_epi16(INT16_MAX);
+	__m128i theMax = _mm_set1_epi16(INT16_MIN);
+	__m128i theSquares = _mm_setzero_si128(); //2 x uint64
+	uint32_t i = 0;
+	while(i < theVectors){
+		uint32_t theEnd = i + INA226_DSP_CHUNK / 8;
+		if(theEnd > theVectors){
+			theEnd = theVectors;
+		}
+		__m128i theSum = _mm_setzero_si128(); //4 x int32
+		for(; i < theEnd; i++){
+			__m128i theValues = _mm_loadu_si128((const __m128i*)&aValues[8 * i]);
+			theMin = _mm_min_epi16(theMin, theValues);
+			theMax = _mm_max_epi16(theMax, theValues);
+			theSum = _mm_add_epi32(theSum, _mm_madd_epi16(theValues, theOnes));
+			//a pair of squares is at most 2^31, so the lanes are read as unsigned
+			__m128i theSq = _mm_madd_epi16(theValues, theValues);
+			theSquares = _mm_add_epi64(theSquares, _mm_unpacklo_epi32(theSq, theZero));
+			theSquares = _mm_add_epi64(theSquares, _mm_unpackhi_epi32(theSq, theZero));
+		}
+		int32_t theLanes[4];
+		_mm_storeu_si128((__m128i*)theLanes, theSum);
+		aStats_p->Sum += (int64_t)theLanes[0] + theLanes[1] + theLanes[2] + theLanes[3];
+	}
+	uint64_t theSquareLanes[2];
+	_mm_storeu_si128((__m128i*)theSquareLanes, theSquares);
+	aStats_p->SumOfSquares += theSquareLanes[0] + theSquareLanes[1];
+	if(theVectors > 0){
+		int16_t theLanes[8];
+		_mm_storeu_si128((__m128i*)theLanes, theMin);
+		for(int k = 0; k < 8; k++) if(theLanes[k] < aStats_p->Min) aStats_p->Min = theLanes[k];
+		_mm_storeu_si128((__m128i*)theLanes, theMax);
+		for(int k = 0; k < 8; k++) if(theLanes[k] > aStats_p->Max) aStats_p->Max = theLanes[k];
+	}
+	return theVectors * 8;
+}
+#else
+static uint32_t INA226_Dsp_Stats_s16_Simd(const int16_t* aValues, uint32_t aCount, INA226_rawstats* aStats_p)
+{
+	(void)aValues; (void)aCount; (void)aStats_p;
+	return 0;
+}
+#endif
+//----------------------------------------------------------------------------
+void INA226_Dsp_Stats_s16(const int16_t* aValues, uint32_t aCount, INA226_rawstats* aStats_p)
+{
+	aStats_p->Min = INT16_MAX;
+	aStats_p->Max = INT16_MIN;
+	aStats_p->Sum = 0;
+	aStats_p->SumOfSquares = 0;
+	aStats_p->Count = aCount;
+
+	uint32_t theDone = INA226_Dsp_Stats_s16_Simd(aValues, aCount, aStats_p);
+	INA226_Dsp_Stats_s16_Scalar(&aValues[theDone], aCount - theDone, aStats_p);
+}
+//----------------------------------------------------------------------------
+void INA226_Dsp_Stats_u16(const uint16_t* aValues, uint32_t aCount, INA226_rawstats* aStats_p)
+{
+	//Plain loop, simple enough for the compiler to vectorise on its own
+	uint32_t theMin = UINT16_MAX;
+	uint32_t theMax = 0;
+	uint64_t theSum = 0;
+	for(uint32_t i = 0; i < aCount; i++){
+		uint32_t theValue = aValues[i];
+		theMin = theValue < theMin ? theValue : theMin;
+		theMax = theValue > theMax ? theValue : theMax;
+		theSum += theValue;
+	}
+	aStats_p->Min = (int32_t)theMin;
+	aStats_p->Max = (int32_t)theMax;
+	aStats_p->Sum = (int64_t)theSum;
+	aStats_p->SumOfSquares = 0;
+	aStats_p->Count = aCount;
+}
+//----------------------------------------------------------------------------
+void INA226_Dsp_Deinterleave(const INA226_raw* aRaw, uint32_t aCount, int16_t* aShunt_p, uint16_t* aBus_p, uint16_t* aPower_p, int16_t* aCurrent_p)
+{
+	for(uint32_t i = 0; i < aCount; i++){
+		if(aShunt_p != NULL)	aShunt_p[i] = aRaw[i].ShuntVoltage;
+		if(aBus_p != NULL)		aBus_p[i] = aRaw[i].BusVoltage;
+		if(aPower_p != NULL)	aPower_p[i] = aRaw[i].Power;
+		if(aCurrent_p != NULL)	aCurrent_p[i] = aRaw[i].Current;
+	}
+}
+//----------------------------------------------------------------------------
+//Integer square root, no libm
+static uint32_t INA226_Dsp_Sqrt(uint64_t aValue)
+{
+	uint64_t theResult = 0;
+	uint64_t theBit = (uint64_t)1 << 62;
+	while(theBit > aValue){
+		theBit >>= 2;
+	}
+	while(theBit != 0){
+		if(aValue >= theResult + theBit){
+			aValue -= theResult + theBit;
+			theResult = (theResult >> 1) + theBit;
+		}else{
+			theResult >>= 1;
+		}
+		theBit >>= 2;
+	}
+	return (uint32_t)theResult;
+}
+//----------------------------------------------------------------------------
+status INA226_Dsp_WindowStats(const INA226_config* aConfig, const int16_t* aCurrent, const uint16_t* aPower, uint32_t aCount,
+		uint32_t aSamplePeriod_us, INA226_window* aWindow_p)
+{
+	if(aCount == 0 || aCurrent == NULL || aPower == NULL){
+		return BAD_PARAMETER;
+	}
+	INA226_rawstats theCurrent;
+	INA226_rawstats thePower;
+	INA226_Dsp_Stats_s16(aCurrent, aCount, &theCurrent);
+	INA226_Dsp_Stats_u16(aPower, aCount, &thePower);
+
+	const int32_t theCurrentLSB = aConfig->mCurrentMicroAmpsPerBit;
+	const int32_t thePowerLSB = aConfig->mPowerMicroWattPerBit;
+
+	aWindow_p->Count = aCount;
+	aWindow_p->CurrentMin_uA = theCurrent.Min * theCurrentLSB;
+	aWindow_p->CurrentMax_uA = theCurrent.Max * theCurrentLSB;
+	aWindow_p->CurrentMean_uA = (int32_t)((theCurrent.Sum * theCurrentLSB) / (int64_t)aCount);
+	//Mean square in raw units with 8 fractional bits (x 2^16 before the root), then scaled
+	uint64_t theMeanSquare = (theCurrent.SumOfSquares / aCount) << 16;
+	theMeanSquare += ((theCurrent.SumOfSquares % aCount) << 16) / aCount;
+	aWindow_p->CurrentRms_uA = (uint32_t)(((uint64_t)INA226_Dsp_Sqrt(theMeanSquare) * (uint32_t)theCurrentLSB) >> 8);
+	aWindow_p->PowerMean_uW = (uint32_t)(((uint64_t)thePower.Sum * (uint32_t)thePowerLSB) / aCount);
+	aWindow_p->Energy_pJ = (uint64_t)thePower.Sum * (uint32_t)thePowerLSB * aSamplePeriod_us;
+	return OK;
+}
@@ -0,0 +1,50 @@
+/*
+ * INA226_dsp.h
+ *
+ * Batch kernels over captured windows of raw INA226 registers: min/max/sum/sum of squares
+ * of one register, and per-window current/power/energy statistics in micro units.
+ * The 16 bit kernels use the Cortex-M4/M7 DSP instructions (through CMSIS), NEON or SSE2
+ * when the compiler targets them, and a portable loop otherwise.
+ * Define INA226_DSP_SCALAR to force the portable loop.
+ */
+
+#ifndef INA226_INA226_DSP_H_
+#define INA226_INA226_DSP_H_
+
+#include "INA226.h"
+
+//Statistics of one register over a window, in raw register units
+typedef struct INA226_rawstats{
+	int32_t		Min;
+	int32_t		Max;
+	int64_t		Sum;
+	uint64_t	SumOfSquares;
+	uint32_t	Count;
+} INA226_rawstats;
+
+//Statistics of a window, in micro units
+typedef struct INA226_window{
+	int32_t		CurrentMin_uA;
+	int32_t		CurrentMax_uA;
+	int32_t		CurrentMean_uA;
+	uint32_t	CurrentRms_uA;
+	uint32_t	PowerMean_uW;
+	uint64_t	Energy_pJ;		//uW * us, over the whole window
+	uint32_t	Count;
+} INA226_window;
+
+//Signed registers (shunt voltage, current), aValues doesn't need to be 4 byte aligned
+void	INA226_Dsp_Stats_s16(const int16_t* aValues, uint32_t aCount, INA226_rawstats* aStats_p);
+//Unsigned registers (bus voltage, power), SumOfSquares is not computed
+void	INA226_Dsp_Stats_u16(const uint16_t* aValues, uint32_t aCount, INA226_rawstats* aStats_p);
+
+//Splits raw samples into one array per register so the kernels above can run on contiguous
+//data. Any destination may be NULL.
+void	INA226_Dsp_Deinterleave(const INA226_raw* aRaw, uint32_t aCount, int16_t* aShunt_p, uint16_t* aBus_p, uint16_t* aPower_p, int16_t* aCurrent_p);
+
+//Current min/max/mean/RMS, mean power and energy of a window of aCount samples taken every
+//aSamplePeriod_us, scaled with the calibration of aConfig
+status	INA226_Dsp_WindowStats(const INA226_config* aConfig, const int16_t* aCurrent, const uint16_t* aPower, uint32_t aCount,
+			uint32_t aSamplePeriod_us, INA226_window* aWindow_p);
+
+#endif /* INA226_INA226_DSP_H_ */
@@ -0,0 +1,106 @@
+/*
+ * INA226_energy.c
+ *
+ * Energy and charge counter, see INA226_energy.h
+ */
+
+#include "INA226_energy.h"
+#include <stddef.h>
+
+static const int64_t cMicroSecsPerHour = 3600000000LL;
+
+//Single writer: fills the reading the readers don't use (its counter odd meanwhile), then publishes it
+static void INA226_Energy_Publish(INA226_energy* this)
+{
+	uint32_t thePublications = this->mPublications + 1;
+	uint8_t theSlot = thePublications & 1;
+	INA226_energy_reading* theReading = &this->mPublished[theSlot];
+	this->mWrites[theSlot]++;
+	INA226_MEMORY_BARRIER();
+	theReading->Energy_uWh = this->mEnergy_uWh;
+	theReading->Charge_uAh = this->mCharge_uAh;
+	theReading->Elapsed_us = this->mElapsed_us;
+	INA226_MEMORY_BARRIER();
+	this->mWrites[theSlot]++;
+	INA226_MEMORY_BARRIER();
+	this->mPublications = thePublications;
+}
+//----------------------------------------------------------------------------
+status INA226_Energy_Sync(INA226_energy* this, const INA226_config* aConfig)
+{
+	uint32_t thePeriod = INA226_GetConversionPeriod_us(aConfig);
+	if(thePeriod == 0){
+		return CONFIG_ERROR;
+	}
+	this->mPeriod_us = thePeriod;
+	this->mCurrentMicroAmpsPerBit = aConfig->mCurrentMicroAmpsPerBit;
+	this->mPowerMicroWattPerBit = aConfig->mPowerMicroWattPerBit;
+	INA226_Energy_Publish(this);
+	return OK;
+}
+//----------------------------------------------------------------------------
+status INA226_Energy_Init(INA226_energy* this, const INA226_config* aConfig)
+{
+	this->mPublications = 0;
+	this->mWrites[0] = 0;
+	this->mWrites[1] = 0;
+	this->mPeriod_us = 0;
+	INA226_Energy_Reset(this);
+	return INA226_Energy_Sync(this, aConfig);
+}
+//----------------------------------------------------------------------------
+void INA226_Energy_Reset(INA226_energy* this)
+{
+	this->mEnergy_uWh = 0;
+	this->mEnergyRemainder = 0;
+	this->mCharge_uAh = 0;
+	this->mChargeRemainder = 0;
+	this->mConversions = 0;
+	this->mElapsed_us = 0;
+	INA226_Energy_Publish(this);
+}
+//----------------------------------------------------------------------------
+void INA226_Energy_Add(INA226_energy* this, const INA226_raw* aRaw, uint32_t aConversions)
+{
+	uint64_t theTime_us = (uint64_t)this->mPeriod_us * aConversions;
+
+	//uW*us and uA*us of this sample, the remainders only carry over once per uWh / uAh
+	this->mEnergyRemainder += (uint64_t)aRaw->Power * (uint32_t)this->mPowerMicroWattPerBit * theTime_us;
+	if(this->mEnergyRemainder >= (uint64_t)cMicroSecsPerHour){
+		uint64_t theWhole = this->mEnergyRemainder / (uint64_t)cMicroSecsPerHour;
+		this->mEnergy_uWh += theWhole;
+		this->mEnergyRemainder -= theWhole * (uint64_t)cMicroSecsPerHour;
+	}
+	this->mChargeRemainder += (int64_t)aRaw->Current * this->mCurrentMicroAmpsPerBit * (int64_t)theTime_us;
+	if(this->mChargeRemainder >= cMicroSecsPerHour || this->mChargeRemainder <= -cMicroSecsPerHour){
+		int64_t theWhole = this->mChargeRemainder / cMicroSecsPerHour;
+		this->mCharge_uAh += theWhole;
+		this->mChargeRemainder -= theWhole * cMicroSecsPerHour;
+	}
+	this->mConversions += aConversions;
+	this->mElapsed_us += theTime_us;
+	INA226_Energy_Publish(this);
+}
+//----------------------------------------------------------------------------
+void INA226_Energy_AddSamples(INA226_energy* this, const INA226_sample* aSamples, uint32_t aCount)
+{
+	for(uint32_t i = 0; i < aCount; i++){
+		INA226_Energy_Add(this, &aSamples[i].Raw, 1);
+	}
+}
+//----------------------------------------------------------------------------
+void INA226_Energy_Get(const INA226_energy* this, INA226_energy_reading* aReading_p)
+{
+	//Seqlock per slot, as INA226_Os_GetLatest: a copy torn by a write to its slot is repeated with
+	//the slot published meanwhile, so an interrupt preempting the writer never waits for it
+	uint32_t thePublications;
+	uint32_t theWrites;
+	do{
+		thePublications = this->mPublications;
+		INA226_MEMORY_BARRIER();
+		theWrites = this->mWrites[thePublications & 1];
+		INA226_MEMORY_BARRIER();
+		*aReading_p = this->mPublished[thePublications & 1];
+		INA226_MEMORY_BARRIER();
+	}while((theWrites & 1) || theWrites != this->mWrites[thePublications & 1]);
+}
@@ -0,0 +1,57 @@
+/*
+ * INA226_energy.h
+ *
+ * Energy (uWh) and charge (uAh) counter. Every sample is integrated over the conversion
+ * period of the configuration register (see INA226_GetConversionPeriod_us), not over
+ * wall-clock time, so timer jitter doesn't matter. The counter holds whole uWh / uAh plus
+ * the remainder in uW*us / uA*us, so nothing is lost to rounding and it doesn't overflow
+ * for practical purposes.
+ * Attach it to an acquisition with INA226_SetEnergyCounter (updated from the interrupt), or feed
+ * it from a task with INA226_Energy_AddSamples. Reading it is O(1) and needs no locking, an
+ * interrupt reading it never waits.
+ */
+
+#ifndef INA226_INA226_ENERGY_H_
+#define INA226_INA226_ENERGY_H_
+
+#include "INA226.h"
+#include "INA226_ring.h"
+
+typedef struct INA226_energy_reading{
+	uint64_t	Energy_uWh;
+	int64_t		Charge_uAh;		//signed, the current register is signed
+	uint64_t	Elapsed_us;		//integrated time
+} INA226_energy_reading;
+
+typedef struct INA226_energy{
+	uint32_t			mPeriod_us;				//integration time of one sample
+	int32_t				mCurrentMicroAmpsPerBit;
+	int32_t				mPowerMicroWattPerBit;
+	uint64_t			mEnergy_uWh;
+	uint64_t			mEnergyRemainder;		//uW*us, < 1 uWh
+	int64_t				mCharge_uAh;
+	int64_t				mChargeRemainder;		//uA*us, < 1 uAh either way
+	uint64_t			mConversions;
+	uint64_t			mElapsed_us;			//each sample with the period it was integrated over
+	INA226_energy_reading	mPublished[2];		//double buffer for INA226_Energy_Get, update n is in mPublished[n & 1]
+	volatile uint32_t	mPublications;
+	volatile uint32_t	mWrites[2];				//per slot of mPublished, odd while it is written
+} INA226_energy;
+
+//Takes the conversion period and the scaling of aConfig and clears the counter.
+//Returns CONFIG_ERROR when the device is shut down. Call it again after reconfiguring the device.
+status	INA226_Energy_Init(INA226_energy* this, const INA226_config* aConfig);
+//Same, but keeps the accumulated values
+status	INA226_Energy_Sync(INA226_energy* this, const INA226_config* aConfig);
+void	INA226_Energy_Reset(INA226_energy* this);
+
+//Integrates one sample over aConversions conversion periods (single writer)
+void	INA226_Energy_Add(INA226_energy* this, const INA226_raw* aRaw, uint32_t aConversions);
+//Integrates samples of consecutive conversions, e.g. popped from an INA226_ring
+void	INA226_Energy_AddSamples(INA226_energy* this, const INA226_sample* aSamples, uint32_t aCount);
+
+//Consistent copy of the counter, from any task, core or interrupt. An interrupt preempting the
+//writer never waits for it, a copy torn by a concurrent update is detected and repeated.
+void	INA226_Energy_Get(const INA226_energy* this, INA226_energy_reading* aReading_p);
+
+#endif /* INA226_INA226_ENERGY_H_ */
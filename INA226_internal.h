@@ -0,0 +1,26 @@
+/*
+ * INA226_internal.h
+ *
+ * Helpers shared by the source files of the driver, not part of the API.
+ */
+
+#ifndef INA226_INA226_INTERNAL_H_
+#define INA226_INA226_INTERNAL_H_
+
+#include "INA226.h"
+
+//Returns the status of fn from the calling function unless it is OK
+#define CALL_FN(fn) { status s = (fn); if(s != OK){return s;} }
+
+//Bus wrappers of INA226.c for the modules that run their own transfers on a device's transport,
+//so mBusTransactions, the tracer and the failure policy see that traffic too.
+//Async transfers: 0 if started, report the end with INA226_BusAsyncEnd (0 for success).
+int		INA226_BusReadRegisterAsync(INA226_config* this, uint8_t aRegister, uint8_t* buffer, uint16_t Size);
+int		INA226_BusReceiveAsync(INA226_config* this, uint8_t* buffer, uint16_t Size);
+void	INA226_BusAsyncEnd(INA226_config* this, int aResult);
+//Counts a failed access towards mDegradeAfter (OK clears the count), returns aStatus
+status	INA226_AccountAccess(INA226_config* this, status aStatus);
+//Pointer write with the retries and the degraded check of INA226_WriteRegister
+status	INA226_SetRegisterPointer(INA226_config* this, uint8_t aRegister);
+
+#endif /* INA226_INA226_INTERNAL_H_ */
@@ -0,0 +1,177 @@
+/*
+ * INA226_osal.c
+ *
+ * RTOS integration, see INA226_osal.h
+ */
+
+#include "INA226_osal.h"
+#include "INA226_internal.h"
+#include "INA226_ring.h"
+#include <stddef.h>
+
+//Transfer complete / error interrupt of the sequence a task waits for
+static void INA226_Os_TransferDone(INA226* aDevice, status aStatus)
+{
+	INA226_osal* this = aDevice->Async.mOsal;
+	if(this->mWaitDevice != aDevice){
+		return; //completion of a sequence that timed out, nobody waits for it any more
+	}
+	this->mWaitStatus = aStatus;
+	this->mWaitDone = true;
+	this->Signal(this->mEvent);
+}
+
+//Called with the mutex taken, before the sequence is started
+static status INA226_Os_Begin(INA226_osal* this, INA226* aDevice)
+{
+	if(INA226_AsyncIsBusy(aDevice)){
+		return INA226_BUSY;
+	}
+	while(this->Wait(this->mEvent, 0)){
+		//signal of a sequence that completed after its timeout
+	}
+	this->mWaitDone = false;
+	this->mWaitStatus = OK;
+	aDevice->Async.mOsal = this;
+	this->mWaitDevice = aDevice;
+	return OK;
+}
+
+//Sleeps until the sequence started with aStarted completes, then releases the mutex
+static status INA226_Os_End(INA226_osal* this, status aStarted, uint32_t aTimeout_ms)
+{
+	status theStatus = aStarted;
+	if(aStarted == OK){
+		//Wake-ups without mWaitDone are stale signals, wait again
+		while(!this->mWaitDone && this->Wait(this->mEvent, aTimeout_ms)){
+		}
+		theStatus = this->mWaitDone ? this->mWaitStatus : INA226_OS_TIMEOUT;
+	}
+	INA226* theDevice = this->mWaitDevice;
+	this->mWaitDevice = NULL;
+	if(theStatus == INA226_OS_TIMEOUT && this->Abort != NULL){
+		//Stop the peripheral, then finish the sequence so the device can be used again
+		this->Abort(theDevice);
+		INA226_AsyncTransferError(theDevice);
+	}
+	this->Unlock(this->mMutex);
+	return theStatus;
+}
+//----------------------------------------------------------------------------
+status INA226_Os_Lock(INA226_osal* this, uint32_t aTimeout_ms)
+{
+	return this->Lock(this->mMutex, aTimeout_ms) ? OK : INA226_BUSY;
+}
+//----------------------------------------------------------------------------
+void INA226_Os_Unlock(INA226_osal* this)
+{
+	this->Unlock(this->mMutex);
+}
+//----------------------------------------------------------------------------
+status INA226_Os_Measure(INA226_osal* this, INA226* aDevice, uint8_t aSelection, uint32_t aTimeout_ms)
+{
+	CALL_FN(INA226_Os_Lock(this, aTimeout_ms));
+	status theStatus = INA226_Os_Begin(this, aDevice);
+	if(theStatus == OK){
+		theStatus = INA226_MeasureAsync(aDevice, aSelection, INA226_Os_TransferDone);
+	}
+	return INA226_Os_End(this, theStatus, aTimeout_ms);
+}
+//----------------------------------------------------------------------------
+status INA226_Os_ReadRegister(INA226_osal* this, INA226* aDevice, uint8_t aRegister, uint16_t* aValue_p, uint32_t aTimeout_ms)
+{
+	CALL_FN(INA226_Os_Lock(this, aTimeout_ms));
+	status theStatus = INA226_Os_Begin(this, aDevice);
+	if(theStatus == OK){
+		theStatus = INA226_ReadRegisterAsync(aDevice, aRegister, INA226_Os_TransferDone);
+	}
+	theStatus = INA226_Os_End(this, theStatus, aTimeout_ms);
+	if(theStatus == OK){
+		*aValue_p = aDevice->Async.mValues[0];
+	}
+	return theStatus;
+}
+//----------------------------------------------------------------------------
+status INA226_Os_WriteRegister(INA226_osal* this, INA226* aDevice, uint8_t aRegister, uint16_t aValue, uint32_t aTimeout_ms)
+{
+	CALL_FN(INA226_Os_Lock(this, aTimeout_ms));
+	status theStatus = INA226_Os_Begin(this, aDevice);
+	if(theStatus == OK){
+		theStatus = INA226_WriteRegistersAsync(aDevice, &aRegister, &aValue, 1, INA226_Os_TransferDone);
+	}
+	return INA226_Os_End(this, theStatus, aTimeout_ms);
+}
+//----------------------------------------------------------------------------
+void INA226_Os_AcquisitionInit(INA226_os_acquisition* this, INA226_osal* aOsal, INA226* aDevice, uint8_t aSelection, uint32_t aPeriod_ms)
+{
+	this->mOsal = aOsal;
+	this->mDevice = aDevice;
+	this->mSelection = aSelection;
+	this->mPeriod_ms = aPeriod_ms;
+	this->mTimeout_ms = 0;
+	this->mStop = false;
+	this->mWrites[0] = 0;
+	this->mWrites[1] = 0;
+	this->mSamples = 0;
+	this->mErrors = 0;
+	this->mLastStatus = OK;
+}
+//----------------------------------------------------------------------------
+status INA226_Os_AcquisitionStep(INA226_os_acquisition* this)
+{
+	uint32_t theTimeout = this->mTimeout_ms != 0 ? this->mTimeout_ms : this->mPeriod_ms;
+	status theStatus = INA226_Os_Measure(this->mOsal, this->mDevice, this->mSelection, theTimeout);
+	this->mLastStatus = theStatus;
+	if(theStatus != OK){
+		this->mErrors++;
+		return theStatus;
+	}
+	//Single writer: fill the slot the readers don't use (its counter odd meanwhile), then publish it
+	uint32_t theSamples = this->mSamples + 1;
+	uint8_t theSlot = theSamples & 1;
+	this->mWrites[theSlot]++;
+	INA226_MEMORY_BARRIER();
+	this->mLatest[theSlot] = this->mDevice->Result;
+	INA226_MEMORY_BARRIER();
+	this->mWrites[theSlot]++;
+	INA226_MEMORY_BARRIER();
+	this->mSamples = theSamples;
+	return OK;
+}
+//----------------------------------------------------------------------------
+void INA226_Os_AcquisitionTask(void* aAcquisition)
+{
+	INA226_os_acquisition* this = (INA226_os_acquisition*)aAcquisition;
+	INA226_osal* theOsal = this->mOsal;
+	//Absolute wake-up times: the time of the measurements doesn't add up to a drift
+	uint32_t theWake = theOsal->Now_ms();
+	while(!this->mStop){
+		INA226_Os_AcquisitionStep(this);
+		theWake += this->mPeriod_ms;
+		uint32_t theLate = theOsal->Now_ms() - theWake;
+		if((int32_t)theLate >= (int32_t)this->mPeriod_ms && this->mPeriod_ms != 0){
+			//A period or more behind (e.g. a timeout): skip the missed periods instead of catching up
+			theWake += theLate / this->mPeriod_ms * this->mPeriod_ms;
+		}
+		theOsal->SleepUntil(theWake);
+	}
+}
+//----------------------------------------------------------------------------
+uint32_t INA226_Os_GetLatest(const INA226_os_acquisition* this, INA226_result* aResult_p)
+{
+	//Seqlock per slot: the copy is repeated if the writer wrote to the slot while (or before) it
+	//was copied. That needs the writer to have published the next sample meanwhile, so the repeat
+	//copies the other, complete slot: an interrupt preempting the writer never waits for it, and
+	//another task or core only retries while the writer is making progress.
+	uint32_t theSamples;
+	uint32_t theWrites;
+	do{
+		theSamples = this->mSamples;
+		INA226_MEMORY_BARRIER();
+		theWrites = this->mWrites[theSamples & 1];
+		INA226_MEMORY_BARRIER();
+		*aResult_p = this->mLatest[theSamples & 1];
+		INA226_MEMORY_BARRIER();
+	}while((theWrites & 1) || theWrites != this->mWrites[theSamples & 1]);
+	return theSamples;
+}
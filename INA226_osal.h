@@ -0,0 +1,91 @@
+/*
+ * INA226_osal.h
+ *
+ * RTOS integration. The hooks of an INA226_osal (one per I2C peripheral) give the driver a bus
+ * mutex and a transfer complete event, so a task blocks on a measurement instead of busy waiting
+ * in the HAL: the transfers run through the non-blocking engine (INA226_MeasureAsync, ...) and the
+ * task sleeps until the completion interrupt signals the event.
+ * With an INA226_os_acquisition task owning the bus, the other tasks only read the latest sample
+ * (INA226_Os_GetLatest), which is O(1), never blocks and never touches the bus.
+ *
+ * FreeRTOS, e.g.:
+ *   Lock:   xSemaphoreTake(mutex, pdMS_TO_TICKS(ms)) == pdTRUE    Unlock: xSemaphoreGive(mutex)
+ *   Wait:   xSemaphoreTake(binary, pdMS_TO_TICKS(ms)) == pdTRUE   Signal: xSemaphoreGiveFromISR(binary, ..)
+ *   Now_ms: pdTICKS_TO_MS(xTaskGetTickCount())
+ *   SleepUntil: vTaskDelay(pdMS_TO_TICKS(wake - Now_ms())) if the difference is positive (as int32_t)
+ *   Abort:  HAL_I2C_Master_Abort_IT(hi2c, address << 1), or a reset of the DMA channel and the I2C
+ * Task notifications work as well (ulTaskNotifyTake / vTaskNotifyGiveFromISR to the waiting task):
+ * only the task holding the mutex waits, so there is one waiter at a time.
+ * Zephyr: k_mutex_lock / k_mutex_unlock, k_sem_take / k_sem_give, k_uptime_get_32, k_msleep.
+ */
+
+#ifndef INA226_INA226_OSAL_H_
+#define INA226_INA226_OSAL_H_
+
+#include "INA226.h"
+
+#define INA226_OS_WAIT_FOREVER	0xFFFFFFFFu //timeout of the hooks, map it to portMAX_DELAY / K_FOREVER
+
+typedef struct INA226_osal{
+	void*		mMutex;			//passed to Lock / Unlock
+	void*		mEvent;			//passed to Wait / Signal
+	//false if the mutex couldn't be taken within aTimeout_ms
+	bool		(*Lock)(void* aMutex, uint32_t aTimeout_ms);
+	void		(*Unlock)(void* aMutex);
+	//Task side, false on timeout. Called with aTimeout_ms 0 to drop a stale signal.
+	bool		(*Wait)(void* aEvent, uint32_t aTimeout_ms);
+	//Interrupt side (the transfer complete / error interrupt)
+	void		(*Signal)(void* aEvent);
+	//Time base of the acquisition task: a free running millisecond counter (may wrap) and a sleep
+	//until it reaches aWake_ms, returning at once if that is not in the future
+	uint32_t	(*Now_ms)(void);
+	void		(*SleepUntil)(uint32_t aWake_ms);
+	//Stops the transfer of aDevice on the peripheral after a timeout, no interrupt may follow.
+	//NULL: a timed out device stays busy.
+	void		(*Abort)(INA226* aDevice);
+	//State of the transfer waited for, owned by the task holding the mutex
+	INA226* volatile	mWaitDevice;
+	volatile bool		mWaitDone;
+	volatile status		mWaitStatus;
+} INA226_osal;
+
+//Blocking access of a device of this bus, the calling task sleeps while the transfers run.
+//Returns INA226_BUSY if the mutex can't be taken within aTimeout_ms and INA226_OS_TIMEOUT if the
+//transfer doesn't complete in time. The transfer is aborted with the Abort hook then and the device
+//is idle again. Without the hook it is still busy: abort the transfer on the peripheral and call
+//INA226_AsyncTransferError before using it again.
+status	INA226_Os_Measure(INA226_osal* this, INA226* aDevice, uint8_t aSelection, uint32_t aTimeout_ms);
+status	INA226_Os_ReadRegister(INA226_osal* this, INA226* aDevice, uint8_t aRegister, uint16_t* aValue_p, uint32_t aTimeout_ms);
+status	INA226_Os_WriteRegister(INA226_osal* this, INA226* aDevice, uint8_t aRegister, uint16_t aValue, uint32_t aTimeout_ms);
+//Exclusive use of the bus for the blocking API (configuration, calibration, ...)
+status	INA226_Os_Lock(INA226_osal* this, uint32_t aTimeout_ms);
+void	INA226_Os_Unlock(INA226_osal* this);
+
+//Acquisition task: measures one device every mPeriod_ms (fixed rate, missed periods are skipped)
+//and publishes the result
+typedef struct INA226_os_acquisition{
+	INA226_osal*		mOsal;
+	INA226*				mDevice;
+	uint8_t				mSelection;		//eMeasureSelect flags of every sample
+	uint32_t			mPeriod_ms;
+	uint32_t			mTimeout_ms;	//of each measurement, 0: mPeriod_ms
+	volatile bool		mStop;			//INA226_Os_AcquisitionTask returns when set
+	INA226_result		mLatest[2];		//double buffer, sample n is in mLatest[n & 1]
+	volatile uint32_t	mWrites[2];		//per slot, odd while it is written
+	volatile uint32_t	mSamples;		//samples published
+	volatile uint32_t	mErrors;		//failed measurements, the latest sample stays the last good one
+	volatile status		mLastStatus;
+} INA226_os_acquisition;
+
+void		INA226_Os_AcquisitionInit(INA226_os_acquisition* this, INA226_osal* aOsal, INA226* aDevice, uint8_t aSelection, uint32_t aPeriod_ms);
+//One measurement and publication, for an existing task loop
+status		INA226_Os_AcquisitionStep(INA226_os_acquisition* this);
+//Task entry (void* argument: the INA226_os_acquisition), e.g.
+//xTaskCreate(INA226_Os_AcquisitionTask, "ina226", 256, &acquisition, prio, NULL)
+void		INA226_Os_AcquisitionTask(void* aAcquisition);
+//Latest sample, from any task, core or interrupt. An interrupt preempting the acquisition task
+//never waits for it, a copy torn by a concurrent write is detected and repeated.
+//Returns its number (mSamples), 0 if there is none yet.
+uint32_t	INA226_Os_GetLatest(const INA226_os_acquisition* this, INA226_result* aResult_p);
+
+#endif /* INA226_INA226_OSAL_H_ */
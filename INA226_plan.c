@@ -0,0 +1,98 @@
+/*
+ * INA226_plan.c
+ *
+ * Averaging / conversion time planner, see INA226_plan.h
+ */
+
+#include "INA226_plan.h"
+#include <stddef.h>
+
+static const int cMaxTableIdx = 7;
+
+//Integer square root, no libm
+static uint32_t INA226_Plan_Sqrt(uint64_t aValue)
+{
+	uint64_t theResult = 0;
+	uint64_t theBit = (uint64_t)1 << 62;
+	while(theBit > aValue){
+		theBit >>= 2;
+	}
+	while(theBit != 0){
+		if(aValue >= theResult + theBit){
+			aValue -= theResult + theBit;
+			theResult = (theResult >> 1) + theBit;
+		}else{
+			theResult >>= 1;
+		}
+		theBit >>= 2;
+	}
+	return (uint32_t)theResult;
+}
+//----------------------------------------------------------------------------
+uint32_t INA226_Plan_Noise_nV(uint16_t aConfigRegister, uint16_t aOversampling)
+{
+	//Integration time of the shunt conversion, of the bus conversion when only the bus is converted
+	uint16_t theMode = aConfigRegister & 7u;
+	uint8_t theConvTimeIdx = (theMode & 1u) ? (aConfigRegister >> 3) & 7u : (aConfigRegister >> 6) & 7u;
+	uint64_t theIntegration = (uint64_t)caVoltageConvTimeMicroSecs[theConvTimeIdx] * caNumSamplesAveraged[(aConfigRegister >> 9) & 7u] *
+		(aOversampling != 0 ? aOversampling : 1);
+	if((theMode & 3u) == 0){
+		return 0; //shut down
+	}
+	//noise^2 in 1/256 nV, rounded
+	uint64_t theSquare = ((uint64_t)INA226_PLAN_REFERENCE_NOISE_NV * INA226_PLAN_REFERENCE_NOISE_NV * INA226_PLAN_REFERENCE_TIME_US << 16) / theIntegration;
+	return (INA226_Plan_Sqrt(theSquare) + 128) >> 8;
+}
+//----------------------------------------------------------------------------
+status INA226_Plan(uint32_t aOutputPeriod_us, uint32_t aNoise_nV, enum eOperatingMode aMode, INA226_plan* aPlan_p)
+{
+	if(aMode < ShuntVoltageContinuous || aMode > ShuntAndBusVoltageContinuous){
+		return BAD_PARAMETER; //triggered modes convert on demand, there is no conversion period to plan
+	}
+	bool theFound = false;
+	INA226_plan theBest;
+	for(uint16_t theOversampling = 1; theOversampling <= INA226_PLAN_MAX_OVERSAMPLING; theOversampling++){
+		//Longest conversion period that gives theOversampling results per output, then the most averaging
+		uint32_t theBudget = aOutputPeriod_us / theOversampling;
+		INA226_settings theSettings = {0, 0, 0, aMode};
+		uint16_t theConfig = 0;
+		uint32_t thePeriod = 0;
+		for(int a = 0; a <= cMaxTableIdx; a++){
+			for(int t = 0; t <= cMaxTableIdx; t++){
+				INA226_settings theCandidate = {a, t, t, aMode};
+				uint16_t theCandidateConfig;
+				INA226_EncodeSettings(&theCandidate, &theCandidateConfig);
+				uint32_t theCandidatePeriod = INA226_ConfigConversionPeriod_us(theCandidateConfig);
+				if(theCandidatePeriod > theBudget || theCandidatePeriod < thePeriod ||
+					(theCandidatePeriod == thePeriod && a <= theSettings.mSampleAveragingIdx)){
+					continue;
+				}
+				theSettings = theCandidate;
+				theConfig = theCandidateConfig;
+				thePeriod = theCandidatePeriod;
+			}
+		}
+		if(thePeriod == 0){
+			break; //nothing fits, more oversampling only shortens the budget
+		}
+		uint32_t theNoise = INA226_Plan_Noise_nV(theConfig, theOversampling);
+		if(!theFound || theNoise < theBest.mNoise_nV){
+			theBest.mSettings = theSettings;
+			theBest.mConfigRegister = theConfig;
+			theBest.mOversampling = theOversampling;
+			theBest.mConversionPeriod_us = thePeriod;
+			theBest.mReadPeriod_us = theBudget;
+			theBest.mReadsPerSecond = (uint32_t)((1000000ull * theOversampling + aOutputPeriod_us - 1) / aOutputPeriod_us);
+			theBest.mNoise_nV = theNoise;
+			theFound = true;
+		}
+		if(aNoise_nV == 0 || theNoise <= aNoise_nV){
+			break; //the fewest reads that are quiet enough
+		}
+	}
+	if(!theFound){
+		return BAD_PARAMETER; //aOutputPeriod_us is shorter than the fastest conversion
+	}
+	*aPlan_p = theBest;
+	return aNoise_nV == 0 || theBest.mNoise_nV <= aNoise_nV ? OK : CONFIG_ERROR;
+}
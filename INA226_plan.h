@@ -0,0 +1,47 @@
+/*
+ * INA226_plan.h
+ *
+ * Picks the averaging and conversion time for a target output period and noise level, so that
+ * the device does the averaging and the host reads it as seldom as possible.
+ * Noise model: white noise, the standard deviation of a result falls with the square root of
+ * its integration time (averaging * conversion time * results averaged by the host):
+ *   noise = INA226_PLAN_REFERENCE_NOISE_NV * sqrt(INA226_PLAN_REFERENCE_TIME_US / integration)
+ * Averaging n results in software costs n reads for the noise one read of n times the hardware
+ * averaging gives, so the host only oversamples when the hardware can't integrate long enough.
+ */
+
+#ifndef INA226_INA226_PLAN_H_
+#define INA226_INA226_PLAN_H_
+
+#include "INA226.h"
+
+//Standard deviation of a single shunt conversion of INA226_PLAN_REFERENCE_TIME_US, nV.
+//Depends on the board: measure it (shunt register, no averaging, inputs shorted) and define it.
+#ifndef INA226_PLAN_REFERENCE_NOISE_NV
+#define INA226_PLAN_REFERENCE_NOISE_NV	2500 //one shunt LSB
+#endif
+#define INA226_PLAN_REFERENCE_TIME_US	1100
+#define INA226_PLAN_MAX_OVERSAMPLING	64	//results averaged by the host per output, at most
+
+typedef struct INA226_plan{
+	INA226_settings	mSettings;			//for INA226_Configure, the bus uses the shunt conversion time
+	uint16_t		mConfigRegister;	//same as a configuration word
+	uint16_t		mOversampling;		//results the host reads and averages per output, 1: none
+	uint32_t		mConversionPeriod_us; //time between two results of the device
+	uint32_t		mReadPeriod_us;		//read the device this often, e.g. the period of INA226_Bus_Add
+	uint32_t		mReadsPerSecond;
+	uint32_t		mNoise_nV;			//expected standard deviation of an output
+} INA226_plan;
+
+//aOutputPeriod_us: one output at least this often. aNoise_nV: largest standard deviation of the
+//shunt voltage of an output (0: no limit, the lowest noise that fits the period is taken).
+//aMode: continuous operating mode (BAD_PARAMETER otherwise), the noise applies to the bus voltage
+//in BusVoltageContinuous.
+//Takes the fewest reads per second that reach aNoise_nV, then the longest conversion period that
+//fits (lowest noise), then the most averaging. Returns CONFIG_ERROR when aNoise_nV can't be reached
+//within aOutputPeriod_us, *aPlan_p is the lowest noise plan then.
+status	INA226_Plan(uint32_t aOutputPeriod_us, uint32_t aNoise_nV, enum eOperatingMode aMode, INA226_plan* aPlan_p);
+//Expected noise of a configuration word with the host averaging aOversampling results, nV
+uint32_t INA226_Plan_Noise_nV(uint16_t aConfigRegister, uint16_t aOversampling);
+
+#endif /* INA226_INA226_PLAN_H_ */
@@ -0,0 +1,170 @@
+/*
+ * INA226_record.c
+ *
+ * Packed binary sample blocks, see INA226_record.h
+ */
+
+#include "INA226_record.h"
+#include <stddef.h>
+
+static const uint16_t cMaxTimestampDelta = 0xFFFF;
+
+static void INA226_Record_Put16(uint8_t* aOut, uint16_t aValue)
+{
+	aOut[0] = (uint8_t)aValue;
+	aOut[1] = (uint8_t)(aValue >> 8);
+}
+
+static void INA226_Record_Put32(uint8_t* aOut, uint32_t aValue)
+{
+	INA226_Record_Put16(aOut, (uint16_t)aValue);
+	INA226_Record_Put16(aOut + 2, (uint16_t)(aValue >> 16));
+}
+
+static uint16_t INA226_Record_Get16(const uint8_t* aIn)
+{
+	return (uint16_t)(aIn[0] | aIn[1] << 8);
+}
+
+static uint32_t INA226_Record_Get32(const uint8_t* aIn)
+{
+	return INA226_Record_Get16(aIn) | (uint32_t)INA226_Record_Get16(aIn + 2) << 16;
+}
+//----------------------------------------------------------------------------
+uint16_t INA226_Record_ConfigHash(const INA226_config* aConfig)
+{
+	//FNV-1a over the scaling fields, folded to 16 bits
+	uint8_t theBytes[8];
+	INA226_Record_Put16(&theBytes[0], aConfig->mConfigRegister);
+	INA226_Record_Put16(&theBytes[2], aConfig->mCalibrationValue);
+	INA226_Record_Put32(&theBytes[4], (uint32_t)aConfig->mCurrentMicroAmpsPerBit);
+	uint32_t theHash = 2166136261u;
+	for(uint8_t i = 0; i < sizeof(theBytes); i++){
+		theHash = (theHash ^ theBytes[i]) * 16777619u;
+	}
+	return (uint16_t)(theHash ^ (theHash >> 16));
+}
+//----------------------------------------------------------------------------
+uint32_t INA226_Record_Pack(const INA226_config* aConfig, uint8_t aDeviceId, const INA226_sample* aSamples, uint32_t aCount,
+							uint8_t* aOut, uint32_t aOutSize, uint32_t* aPacked_p)
+{
+	uint32_t theCount = aOutSize < INA226_RECORD_HEADER_SIZE ? 0 : (aOutSize - INA226_RECORD_HEADER_SIZE) / INA226_RECORD_SIZE;
+	if(theCount > aCount){
+		theCount = aCount;
+	}
+	if(theCount > INA226_RECORD_MAX_COUNT){
+		theCount = INA226_RECORD_MAX_COUNT;
+	}
+	if(aPacked_p != NULL){
+		*aPacked_p = theCount;
+	}
+	if(theCount == 0){
+		return 0;
+	}
+
+	//Finest resolution whose deltas fit in 16 bits, +1 unit of margin for the rounding
+	uint32_t theMaxGap = 0;
+	for(uint32_t i = 1; i < theCount; i++){
+		uint32_t theGap = aSamples[i].Timestamp - aSamples[i - 1].Timestamp;
+		if(theGap > theMaxGap){
+			theMaxGap = theGap;
+		}
+	}
+	uint8_t theShift = 0;
+	while((theMaxGap >> theShift) >= cMaxTimestampDelta){
+		theShift++;
+	}
+
+	aOut[0] = INA226_RECORD_MAGIC;
+	aOut[1] = INA226_RECORD_VERSION;
+	aOut[2] = aDeviceId;
+	aOut[3] = (uint8_t)theCount;
+	INA226_Record_Put16(&aOut[4], INA226_Record_ConfigHash(aConfig));
+	INA226_Record_Put16(&aOut[6], aConfig->mConfigRegister);
+	INA226_Record_Put16(&aOut[8], aConfig->mCalibrationValue);
+	INA226_Record_Put32(&aOut[10], (uint32_t)aConfig->mCurrentMicroAmpsPerBit);
+	INA226_Record_Put32(&aOut[14], aSamples[0].Timestamp);
+	aOut[18] = theShift;
+	aOut[19] = 0;
+
+	//Deltas against the reconstructed time, so the rounding error stays below half a unit
+	uint32_t theTime = aSamples[0].Timestamp;
+	uint32_t theHalfUnit = theShift != 0 ? 1u << (theShift - 1) : 0;
+	uint8_t* theRecord = aOut + INA226_RECORD_HEADER_SIZE;
+	for(uint32_t i = 0; i < theCount; i++, theRecord += INA226_RECORD_SIZE){
+		const INA226_raw* theRaw = &aSamples[i].Raw;
+		uint16_t theDelta = 0;
+		if(i != 0){
+			theDelta = (uint16_t)(((uint64_t)(aSamples[i].Timestamp - theTime) + theHalfUnit) >> theShift);
+			theTime += (uint32_t)theDelta << theShift;
+		}
+		INA226_Record_Put16(&theRecord[0], theDelta);
+		INA226_Record_Put16(&theRecord[2], (uint16_t)theRaw->ShuntVoltage);
+		INA226_Record_Put16(&theRecord[4], theRaw->BusVoltage);
+		INA226_Record_Put16(&theRecord[6], theRaw->Power);
+		INA226_Record_Put16(&theRecord[8], (uint16_t)theRaw->Current);
+	}
+	return INA226_RECORD_HEADER_SIZE + theCount * INA226_RECORD_SIZE;
+}
+//----------------------------------------------------------------------------
+uint32_t INA226_Record_PackRing(INA226_ring* aRing, const INA226_config* aConfig, uint8_t aDeviceId, uint8_t* aOut, uint32_t aOutSize)
+{
+	//One contiguous run of the storage per block, a block ends at the wrap of the ring
+	const INA226_sample* theSamples;
+	uint32_t theAvailable = INA226_Ring_Peek(aRing, &theSamples);
+	uint32_t thePacked;
+	uint32_t theSize = INA226_Record_Pack(aConfig, aDeviceId, theSamples, theAvailable, aOut, aOutSize, &thePacked);
+	INA226_Ring_Release(aRing, thePacked);
+	return theSize;
+}
+//----------------------------------------------------------------------------
+status INA226_Record_ParseHeader(const uint8_t* aIn, uint32_t aSize, INA226_record_header* aHeader_p, uint32_t* aBlockSize_p)
+{
+	if(aSize < INA226_RECORD_HEADER_SIZE || aIn[0] != INA226_RECORD_MAGIC){
+		return BAD_PARAMETER;
+	}
+	if(aIn[1] != INA226_RECORD_VERSION){
+		return CONFIG_ERROR;
+	}
+	aHeader_p->mVersion = aIn[1];
+	aHeader_p->mDeviceId = aIn[2];
+	aHeader_p->mCount = aIn[3];
+	aHeader_p->mConfigHash = INA226_Record_Get16(&aIn[4]);
+	aHeader_p->mConfigRegister = INA226_Record_Get16(&aIn[6]);
+	aHeader_p->mCalibration = INA226_Record_Get16(&aIn[8]);
+	aHeader_p->mCurrentMicroAmpsPerBit = INA226_Record_Get32(&aIn[10]);
+	aHeader_p->mTimestamp = INA226_Record_Get32(&aIn[14]);
+	aHeader_p->mTimestampShift = aIn[18];
+	uint32_t theBlockSize = INA226_RECORD_HEADER_SIZE + (uint32_t)aHeader_p->mCount * INA226_RECORD_SIZE;
+	if(aBlockSize_p != NULL){
+		*aBlockSize_p = theBlockSize;
+	}
+	if(aSize < theBlockSize || aHeader_p->mTimestampShift > 31){
+		return BAD_PARAMETER;
+	}
+	return OK;
+}
+//----------------------------------------------------------------------------
+uint32_t INA226_Record_Unpack(const INA226_record_header* aHeader, const uint8_t* aIn, INA226_sample* aSamples_p, uint32_t aMaxCount)
+{
+	uint32_t theCount = aHeader->mCount < aMaxCount ? aHeader->mCount : aMaxCount;
+	uint32_t theTime = aHeader->mTimestamp;
+	const uint8_t* theRecord = aIn + INA226_RECORD_HEADER_SIZE;
+	for(uint32_t i = 0; i < theCount; i++, theRecord += INA226_RECORD_SIZE){
+		theTime += (uint32_t)INA226_Record_Get16(&theRecord[0]) << aHeader->mTimestampShift;
+		aSamples_p[i].Timestamp = theTime;
+		aSamples_p[i].Raw.ShuntVoltage = (int16_t)INA226_Record_Get16(&theRecord[2]);
+		aSamples_p[i].Raw.BusVoltage = INA226_Record_Get16(&theRecord[4]);
+		aSamples_p[i].Raw.Power = INA226_Record_Get16(&theRecord[6]);
+		aSamples_p[i].Raw.Current = (int16_t)INA226_Record_Get16(&theRecord[8]);
+	}
+	return theCount;
+}
+//----------------------------------------------------------------------------
+void INA226_Record_Scaling(const INA226_record_header* aHeader, INA226_config* aConfig_p)
+{
+	aConfig_p->mConfigRegister = aHeader->mConfigRegister;
+	aConfig_p->mCalibrationValue = aHeader->mCalibration;
+	aConfig_p->mCurrentMicroAmpsPerBit = (int32_t)aHeader->mCurrentMicroAmpsPerBit;
+	aConfig_p->mPowerMicroWattPerBit = (int32_t)aHeader->mCurrentMicroAmpsPerBit * INA226_POWER_LSB_RATIO;
+}
@@ -0,0 +1,75 @@
+/*
+ * INA226_record.h
+ *
+ * Packed binary format of raw samples for telemetry, and the matching decoder.
+ * A block is a header followed by fixed size records, all fields little endian:
+ *
+ *   header (INA226_RECORD_HEADER_SIZE bytes)
+ *     0  uint8   INA226_RECORD_MAGIC
+ *     1  uint8   INA226_RECORD_VERSION
+ *     2  uint8   device id (e.g. the I2C address)
+ *     3  uint8   number of records
+ *     4  uint16  configuration hash (INA226_Record_ConfigHash), changes with the scaling
+ *     6  uint16  configuration register
+ *     8  uint16  calibration register
+ *    10  uint32  current LSB in uA, the power LSB is INA226_POWER_LSB_RATIO times that
+ *    14  uint32  timestamp of the first record, us
+ *    18  uint8   timestamp shift: the record deltas are in units of 2^shift us
+ *    19  uint8   reserved, 0
+ *   record (INA226_RECORD_SIZE bytes)
+ *     0  uint16  timestamp delta to the previous record (0 for the first one)
+ *     2  int16   shunt voltage register
+ *     4  uint16  bus voltage register
+ *     6  uint16  power register
+ *     8  int16   current register
+ *
+ * 10 bytes per sample instead of 16 for an INA226_result plus timestamp, no formatting cost.
+ */
+
+#ifndef INA226_INA226_RECORD_H_
+#define INA226_INA226_RECORD_H_
+
+#include "INA226.h"
+#include "INA226_ring.h"
+
+#define INA226_RECORD_MAGIC			0xA6
+#define INA226_RECORD_VERSION		1
+#define INA226_RECORD_HEADER_SIZE	20
+#define INA226_RECORD_SIZE			10
+#define INA226_RECORD_MAX_COUNT		255
+//Largest block, for sizing the transmit buffer
+#define INA226_RECORD_MAX_BLOCK		(INA226_RECORD_HEADER_SIZE + INA226_RECORD_MAX_COUNT * INA226_RECORD_SIZE)
+
+typedef struct INA226_record_header{
+	uint8_t		mVersion;
+	uint8_t		mDeviceId;
+	uint8_t		mCount;
+	uint16_t	mConfigHash;
+	uint16_t	mConfigRegister;
+	uint16_t	mCalibration;
+	uint32_t	mCurrentMicroAmpsPerBit;
+	uint32_t	mTimestamp;
+	uint8_t		mTimestampShift;
+} INA226_record_header;
+
+//16 bit hash of the settings that define the scaling (configuration, calibration, LSB)
+uint16_t	INA226_Record_ConfigHash(const INA226_config* aConfig);
+
+//Packs up to aCount samples into one block at aOut. The timestamp resolution is the finest that
+//fits the largest gap of the block, the rounding doesn't accumulate. Returns the block size,
+//0 if aOutSize can't hold the header and one record. *aPacked_p (may be NULL) is the number of samples packed.
+uint32_t	INA226_Record_Pack(const INA226_config* aConfig, uint8_t aDeviceId, const INA226_sample* aSamples, uint32_t aCount,
+							   uint8_t* aOut, uint32_t aOutSize, uint32_t* aPacked_p);
+//Same, straight from the ring storage (INA226_Ring_Peek) into aOut, e.g. the transmit DMA buffer.
+//The packed samples are released from the ring. Returns the block size, 0 if the ring is empty.
+uint32_t	INA226_Record_PackRing(INA226_ring* aRing, const INA226_config* aConfig, uint8_t aDeviceId, uint8_t* aOut, uint32_t aOutSize);
+
+//Receiving side. Checks the magic, the version and that the records are complete.
+//Returns the block size in *aBlockSize_p (may be NULL) to walk a stream of blocks.
+status		INA226_Record_ParseHeader(const uint8_t* aIn, uint32_t aSize, INA226_record_header* aHeader_p, uint32_t* aBlockSize_p);
+//Unpacks the records of a block checked with INA226_Record_ParseHeader, returns the number unpacked
+uint32_t	INA226_Record_Unpack(const INA226_record_header* aHeader, const uint8_t* aIn, INA226_sample* aSamples_p, uint32_t aMaxCount);
+//Fills the scaling of aConfig_p from the header, for INA226_ConvertRawBatch on the receiving side
+void		INA226_Record_Scaling(const INA226_record_header* aHeader, INA226_config* aConfig_p);
+
+#endif /* INA226_INA226_RECORD_H_ */
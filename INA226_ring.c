@@ -0,0 +1,81 @@
+/*
+ * INA226_ring.c
+ *
+ * Lock-free single producer / single consumer sample ring, see INA226_ring.h
+ */
+
+#include "INA226_ring.h"
+#include <stddef.h>
+
+status INA226_Ring_Init(INA226_ring* this, INA226_sample* aBuffer, uint32_t aCapacity)
+{
+	if(aBuffer == NULL || aCapacity == 0 || (aCapacity & (aCapacity - 1)) != 0){
+		return BAD_PARAMETER;
+	}
+	this->mBuffer = aBuffer;
+	this->mMask = aCapacity - 1;
+	this->mHead = 0;
+	this->mTail = 0;
+	return OK;
+}
+//----------------------------------------------------------------------------
+bool INA226_Ring_Push(INA226_ring* this, const INA226_sample* aSample)
+{
+	uint32_t theHead = this->mHead;
+	if(theHead - this->mTail > this->mMask){
+		return false; //full
+	}
+	this->mBuffer[theHead & this->mMask] = *aSample;
+	//The sample must be in memory before the consumer can see the new head
+	INA226_MEMORY_BARRIER();
+	this->mHead = theHead + 1;
+	return true;
+}
+//----------------------------------------------------------------------------
+bool INA226_Ring_Pop(INA226_ring* this, INA226_sample* aSample_p)
+{
+	return INA226_Ring_PopBatch(this, aSample_p, 1) == 1;
+}
+//----------------------------------------------------------------------------
+uint32_t INA226_Ring_PopBatch(INA226_ring* this, INA226_sample* aSamples_p, uint32_t aMaxCount)
+{
+	uint32_t theTail = this->mTail;
+	uint32_t theCount = this->mHead - theTail;
+	//Read the head before the samples it publishes
+	INA226_MEMORY_BARRIER();
+	if(theCount > aMaxCount){
+		theCount = aMaxCount;
+	}
+	for(uint32_t i = 0; i < theCount; i++){
+		aSamples_p[i] = this->mBuffer[(theTail + i) & this->mMask];
+	}
+	//The samples must be copied out before the producer may overwrite them
+	INA226_MEMORY_BARRIER();
+	this->mTail = theTail + theCount;
+	return theCount;
+}
+//----------------------------------------------------------------------------
+uint32_t INA226_Ring_Peek(INA226_ring* this, const INA226_sample** aSamples_p)
+{
+	uint32_t theTail = this->mTail;
+	uint32_t theCount = this->mHead - theTail;
+	INA226_MEMORY_BARRIER();
+	uint32_t theIndex = theTail & this->mMask;
+	uint32_t theContiguous = this->mMask + 1 - theIndex;
+	if(theCount > theContiguous){
+		theCount = theContiguous;
+	}
+	*aSamples_p = &this->mBuffer[theIndex];
+	return theCount;
+}
+//----------------------------------------------------------------------------
+void INA226_Ring_Release(INA226_ring* this, uint32_t aCount)
+{
+	INA226_MEMORY_BARRIER();
+	this->mTail += aCount;
+}
+//----------------------------------------------------------------------------
+uint32_t INA226_Ring_Count(INA226_ring* this)
+{
+	return this->mHead - this->mTail;
+}
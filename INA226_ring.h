@@ -0,0 +1,62 @@
+/*
+ * INA226_ring.h
+ *
+ * Lock-free single producer / single consumer ring of timestamped samples, used to
+ * hand samples over from the acquisition interrupt to a task without disabling interrupts.
+ * The producer (interrupt) only writes mHead, the consumer (task) only writes mTail,
+ * so a push is wait-free and a pop never blocks the producer.
+ */
+
+#ifndef INA226_INA226_RING_H_
+#define INA226_INA226_RING_H_
+
+#include "INA226.h"
+
+//Orders the element copy against the index update. A compiler barrier is enough on a single
+//core Cortex-M, but a DMB is needed when producer and consumer run on different cores.
+#ifndef INA226_MEMORY_BARRIER
+#if defined(__GNUC__) || defined(__clang__)
+#define INA226_MEMORY_BARRIER()	__sync_synchronize()
+#else
+#define INA226_MEMORY_BARRIER()
+#endif
+#endif
+
+//Raw registers only (12 bytes), convert in bulk with INA226_ConvertRawBatch after popping
+typedef struct INA226_sample{
+	uint32_t		Timestamp;	//midpoint of the conversion window, clock set with INA226_SetClock, in microseconds
+	INA226_raw		Raw;
+} INA226_sample;
+
+typedef struct INA226_ring{
+	INA226_sample*		mBuffer;	//storage, statically allocated by the user
+	uint32_t			mMask;		//capacity - 1, the capacity must be a power of two
+	volatile uint32_t	mHead;		//free running write index, only changed by the producer
+	volatile uint32_t	mTail;		//free running read index, only changed by the consumer
+} INA226_ring;
+
+//Defines a statically allocated ring, e.g. INA226_RING_DEFINE(gINA226_Samples, 1024);
+#define INA226_RING_DEFINE(aName, aCapacity) \
+	typedef char aName##_capacity_must_be_power_of_two[((aCapacity) & ((aCapacity) - 1)) == 0 ? 1 : -1]; \
+	static INA226_sample aName##_storage[(aCapacity)]; \
+	INA226_ring aName = { aName##_storage, (aCapacity) - 1, 0, 0 }
+
+//aCapacity must be a power of two, returns BAD_PARAMETER otherwise
+status		INA226_Ring_Init(INA226_ring* this, INA226_sample* aBuffer, uint32_t aCapacity);
+
+//Producer side
+bool		INA226_Ring_Push(INA226_ring* this, const INA226_sample* aSample); //false if full
+
+//Consumer side
+bool		INA226_Ring_Pop(INA226_ring* this, INA226_sample* aSample_p);     //false if empty
+//Copies up to aMaxCount samples to aSamples_p, returns the number copied
+uint32_t	INA226_Ring_PopBatch(INA226_ring* this, INA226_sample* aSamples_p, uint32_t aMaxCount);
+//Zero copy access: returns the longest contiguous run of unread samples (up to the end of the
+//storage) in *aSamples_p. Call INA226_Ring_Release with the number of samples consumed.
+uint32_t	INA226_Ring_Peek(INA226_ring* this, const INA226_sample** aSamples_p);
+void		INA226_Ring_Release(INA226_ring* this, uint32_t aCount);
+
+//Either side
+uint32_t	INA226_Ring_Count(INA226_ring* this);
+
+#endif /* INA226_INA226_RING_H_ */
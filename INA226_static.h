@@ -0,0 +1,93 @@
+/*
+ * INA226_static.h
+ *
+ * Compile-time configured INA226 variant for fixed hardware.
+ * INA226_DEFINE_STATIC generates static inline functions for one device whose address,
+ * shunt and max current are known at compile time. The calibration word, the config word
+ * and the scale factors are constants, so the getters compile to a register read and a
+ * multiply (or shift/add) by a literal.
+ *
+ * Example:
+ *   INA226_DEFINE_STATIC(Battery, INA226_ADRESS_0, 100000, 3276700,
+ *                        INA226_CONFIG_WORD(1, 4, 4, ShuntAndBusVoltageContinuous))
+ *   ...
+ *   INA226 gBattery;
+ *   Battery_Init(&gBattery, NULL, &hi2c1);
+ *   int32_t theCurrent = Battery_GetCurrent_uA(&gBattery);
+ */
+
+#ifndef INA226_INA226_STATIC_H_
+#define INA226_INA226_STATIC_H_
+
+#include "INA226.h"
+
+//Configuration register word as a constant expression, the indices are the ones of
+//INA226_ConfigureNumSampleAveraging / INA226_ConfigureConversionTimes (bit 14 is reserved, reads 1)
+#define INA226_CONFIG_WORD(aSampleAveragingIdx, aBusConvTimeIdx, aShuntConvTimeIdx, aOperatingMode) \
+	((uint16_t)(0x4000u | (((aSampleAveragingIdx) & 7u) << 9) | (((aBusConvTimeIdx) & 7u) << 6) | \
+	(((aShuntConvTimeIdx) & 7u) << 3) | ((aOperatingMode) & 7u)))
+
+//Compile time check of the shunt/current combination (same limits as INA226_setupCalibrationFixedPoint)
+#define INA226_STATIC_ASSERT(aCondition, aName) typedef char aName[(aCondition) ? 1 : -1]
+
+#define INA226_DEFINE_STATIC(aName, aI2C_Address, aShuntResistor_uOhms, aMaxCurrent_uA, aConfigRegister) \
+	enum { \
+		aName##_I2C_ADDRESS       = (aI2C_Address), \
+		aName##_CURRENT_LSB_UA    = (int)INA226_CURRENT_LSB_UA(aMaxCurrent_uA), \
+		aName##_POWER_LSB_UW      = (int)INA226_CURRENT_LSB_UA(aMaxCurrent_uA) * INA226_POWER_LSB_RATIO, \
+		aName##_CALIBRATION       = (int)INA226_CALIBRATION_VALUE(aShuntResistor_uOhms, aMaxCurrent_uA), \
+		aName##_CONFIG            = (int)(aConfigRegister) \
+	}; \
+	INA226_STATIC_ASSERT(INA226_CALIBRATION_VALUE_U64(aShuntResistor_uOhms, aMaxCurrent_uA) > 0 && \
+		INA226_CALIBRATION_VALUE_U64(aShuntResistor_uOhms, aMaxCurrent_uA) <= INA226_CALIBRATION_MAX, \
+		aName##_calibration_out_of_range); \
+	\
+	static inline status aName##_Init(INA226* this, const INA226_transport* aTransport, void* i2c_device) \
+	{ \
+		return INA226_InitPrecomputed(this, aTransport, i2c_device, aName##_I2C_ADDRESS, \
+			(uint16_t)aName##_CONFIG, (uint16_t)aName##_CALIBRATION, aName##_CURRENT_LSB_UA); \
+	} \
+	static inline int32_t aName##_GetShuntVoltage_uV(INA226* this) \
+	{ \
+		uint16_t theRegisterValue = 0; \
+		INA226_ReadRegister(&this->Config, INA226_SHUNT_VOLTAGE_REG, &theRegisterValue); \
+		/* 2.5uV per bit: x/2 + 2x */ \
+		return ((int32_t)(int16_t)theRegisterValue >> 1) + ((int32_t)(int16_t)theRegisterValue << 1); \
+	} \
+	static inline int32_t aName##_GetBusVoltage_uV(INA226* this) \
+	{ \
+		uint16_t theRegisterValue = 0; \
+		INA226_ReadRegister(&this->Config, INA226_BUS_VOLTAGE_REG, &theRegisterValue); \
+		return (int32_t)theRegisterValue * INA226_BUS_VOLTAGE_LSB_UV; \
+	} \
+	static inline int32_t aName##_GetCurrent_uA(INA226* this) \
+	{ \
+		uint16_t theRegisterValue = 0; \
+		INA226_ReadRegister(&this->Config, INA226_CURRENT_REG, &theRegisterValue); \
+		return (int32_t)(int16_t)theRegisterValue * aName##_CURRENT_LSB_UA; \
+	} \
+	static inline int32_t aName##_GetPower_uW(INA226* this) \
+	{ \
+		uint16_t theRegisterValue = 0; \
+		INA226_ReadRegister(&this->Config, INA226_POWER_REG, &theRegisterValue); \
+		return (int32_t)theRegisterValue * aName##_POWER_LSB_UW; \
+	} \
+	/* Same as INA226_MeasureAll, with the constant scale factors */ \
+	static inline status aName##_MeasureAll(INA226* this) \
+	{ \
+		static const uint8_t cRegisters[4] = {INA226_SHUNT_VOLTAGE_REG, INA226_BUS_VOLTAGE_REG, INA226_POWER_REG, INA226_CURRENT_REG}; \
+		uint16_t theValues[4]; \
+		uint32_t theTimestamp = this->Acquisition.mClock != NULL ? this->Acquisition.mClock() - INA226_GetConversionPeriod_us(&this->Config) : 0; \
+		status s = INA226_ReadRegisters(&this->Config, cRegisters, theValues, 4); \
+		if(s != OK){ \
+			return s; \
+		} \
+		this->Result.ShuntVoltage_uV = ((int32_t)(int16_t)theValues[0] >> 1) + ((int32_t)(int16_t)theValues[0] << 1); \
+		this->Result.BusVoltage_uV   = (int32_t)theValues[1] * INA226_BUS_VOLTAGE_LSB_UV; \
+		this->Result.Power_uW        = (int32_t)theValues[2] * aName##_POWER_LSB_UW; \
+		this->Result.Current_uA      = (int32_t)(int16_t)theValues[3] * aName##_CURRENT_LSB_UA; \
+		this->Result.Timestamp       = theTimestamp; \
+		return OK; \
+	}
+
+#endif /* INA226_INA226_STATIC_H_ */
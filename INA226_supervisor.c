@@ -0,0 +1,164 @@
+/*
+ * INA226_supervisor.c
+ *
+ * ALERT pin limit supervision, see INA226_supervisor.h
+ */
+
+#include "INA226_supervisor.h"
+#include "INA226_internal.h"
+#include <stddef.h>
+
+static const uint8_t  cArmRegisters[2]   = {INA226_ALERT_LIMIT_REG, INA226_MASK_ENABLE_REG};
+static const uint16_t cAlertFunctionMask = 0xFC00; //alert function bits of MASK_ENABLE
+static const uint8_t  cAlertRetries      = 3;      //failed cause reads in a row retried from the error interrupt
+
+//----------------------------------------------------------------------------
+int32_t INA226_Supervisor_CurrentLimit_uV(const INA226_config* aConfig, int32_t aCurrent_uA)
+{
+	//Shunt = Current * 2048 / CAL in register units, 2.5uV per shunt bit
+	int64_t theDivisor = (int64_t)aConfig->mCurrentMicroAmpsPerBit * aConfig->mCalibrationValue;
+	if(theDivisor == 0){
+		return 0;
+	}
+	return (int32_t)(((int64_t)aCurrent_uA * 5120) / theDivisor);
+}
+//----------------------------------------------------------------------------
+status INA226_Supervisor_Init(INA226_supervisor* this, INA226* aDevice, const INA226_alert_step* aSteps, uint8_t aCount,
+		INA226_SupervisorCallback aOnAlert)
+{
+	if(!aDevice->Config.mInitialized){
+		return NOT_INITIALIZED;
+	}
+	if(aCount == 0 || aCount > INA226_SUPERVISOR_MAX_STEPS){
+		return BAD_PARAMETER;
+	}
+	for(uint8_t i = 0; i < aCount; i++){
+		uint8_t theNext = aSteps[i].mNext;
+		if(theNext >= aCount && theNext != INA226_SUPERVISOR_STAY && theNext != INA226_SUPERVISOR_STOP){
+			return BAD_PARAMETER;
+		}
+		if(aSteps[i].mTrigger == ClearTriggers || aSteps[i].mTrigger == ConversionReady){
+			return BAD_PARAMETER;
+		}
+		CALL_FN( INA226_EncodeAlertTrigger(&aDevice->Config, aSteps[i].mTrigger, aSteps[i].mLimit, true,
+				&this->mMaskEnable[i], &this->mAlertLimit[i]) );
+		this->mNext[i] = theNext == INA226_SUPERVISOR_STAY ? i : theNext;
+	}
+	this->mDevice = aDevice;
+	this->mCount = aCount;
+	this->mArmed = INA226_SUPERVISOR_STOP;
+	this->mPending = false;
+	this->mFailures = 0;
+	this->mOnAlert = aOnAlert;
+	this->mAlerts = 0;
+	this->mErrors = 0;
+	aDevice->Async.mSupervisor = this;
+	return OK;
+}
+//----------------------------------------------------------------------------
+status INA226_Supervisor_Arm(INA226_supervisor* this, uint8_t aStep)
+{
+	if(aStep >= this->mCount){
+		return BAD_PARAMETER;
+	}
+	if(INA226_AsyncIsBusy(this->mDevice)){
+		return INA226_BUSY;
+	}
+	//Limit first, so the new trigger never compares against the old limit
+	CALL_FN( INA226_WriteRegister(&this->mDevice->Config, INA226_ALERT_LIMIT_REG, this->mAlertLimit[aStep]) );
+	CALL_FN( INA226_WriteRegister(&this->mDevice->Config, INA226_MASK_ENABLE_REG, this->mMaskEnable[aStep]) );
+	this->mArmed = aStep;
+	return OK;
+}
+//----------------------------------------------------------------------------
+status INA226_Supervisor_Disarm(INA226_supervisor* this)
+{
+	if(INA226_AsyncIsBusy(this->mDevice)){
+		return INA226_BUSY;
+	}
+	this->mArmed = INA226_SUPERVISOR_STOP;
+	return INA226_ConfigureAlertPinTrigger(&this->mDevice->Config, ClearTriggers, 0, false);
+}
+//----------------------------------------------------------------------------
+static void INA226_Supervisor_Armed(INA226* aDevice, status aStatus)
+{
+	INA226_supervisor* this = aDevice->Async.mSupervisor;
+	if(aStatus != OK){
+		this->mErrors++;
+		this->mArmed = INA226_SUPERVISOR_STOP;
+		return;
+	}
+	this->mArmed = this->mArming;
+}
+
+static void INA226_Supervisor_CauseRead(INA226* aDevice, status aStatus);
+
+//Reads MASK_ENABLE for a pending alert: it gives the cause and releases the latched ALERT pin
+static void INA226_Supervisor_Service(INA226_supervisor* this, bool aRetryFailed)
+{
+	if(!this->mPending){
+		return;
+	}
+	if(!aRetryFailed && this->mFailures >= cAlertRetries){
+		return;
+	}
+	if(INA226_ReadRegisterAsync(this->mDevice, INA226_MASK_ENABLE_REG, INA226_Supervisor_CauseRead) == OK){
+		this->mPending = false;
+	}
+}
+
+static void INA226_Supervisor_CauseRead(INA226* aDevice, status aStatus)
+{
+	INA226_supervisor* this = aDevice->Async.mSupervisor;
+	if(aStatus != OK){
+		//The pin stays latched until MASK_ENABLE is read, no further edge comes: read again
+		this->mErrors++;
+		this->mFailures++;
+		this->mPending = true;
+		INA226_Supervisor_Service(this, false);
+		return;
+	}
+	this->mFailures = 0;
+	uint16_t theMaskEnable = aDevice->Async.mValues[0];
+	uint8_t theStep = this->mArmed;
+	if(!(theMaskEnable & AlertFunctionFlag) || theStep >= this->mCount){
+		return; //Not an alert of ours (or already disarmed)
+	}
+	this->mAlerts++;
+	if(this->mOnAlert != NULL){
+		this->mOnAlert(this, theStep, (enum eAlertTriggerCause)(theMaskEnable & (AlertFunctionFlag | ConversionReadyFlag | MathOverflowFlag)));
+	}
+	//The callback may have armed another step or disarmed
+	if(this->mArmed != theStep){
+		return;
+	}
+	uint8_t theNext = this->mNext[theStep];
+	if(theNext == INA226_SUPERVISOR_STOP){
+		//Clear the alert function, keep polarity and latch bits
+		uint16_t theValues[2] = {0, (uint16_t)(this->mMaskEnable[theStep] & ~cAlertFunctionMask)};
+		this->mArming = INA226_SUPERVISOR_STOP;
+		if(INA226_WriteRegistersAsync(aDevice, cArmRegisters, theValues, 2, INA226_Supervisor_Armed) != OK){
+			this->mErrors++;
+		}
+		return;
+	}
+	if(theNext == theStep){
+		return; //Same limit stays armed, reading MASK_ENABLE has re-enabled the latch
+	}
+	uint16_t theValues[2] = {this->mAlertLimit[theNext], this->mMaskEnable[theNext]};
+	this->mArming = theNext;
+	if(INA226_WriteRegistersAsync(aDevice, cArmRegisters, theValues, 2, INA226_Supervisor_Armed) != OK){
+		this->mErrors++;
+	}
+}
+//----------------------------------------------------------------------------
+void INA226_Supervisor_AlertISR(INA226_supervisor* this)
+{
+	this->mPending = true;
+	INA226_Supervisor_Service(this, true);
+}
+//----------------------------------------------------------------------------
+void INA226_Supervisor_Poll(INA226_supervisor* this)
+{
+	INA226_Supervisor_Service(this, true);
+}
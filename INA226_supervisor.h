@@ -0,0 +1,67 @@
+/*
+ * INA226_supervisor.h
+ *
+ * Limit supervision on the ALERT pin. The INA226 compares every conversion against one limit,
+ * the supervisor holds a table of limits (steps) and re-arms the next one from the alert
+ * interrupt, e.g. warn -> trip, or under voltage while idle / over current while active.
+ * The limit register values are encoded once at init, the interrupt only reads MASK_ENABLE
+ * (cause of the alert, releases the latched pin) and writes ALERT_LIMIT + MASK_ENABLE,
+ * all with the non-blocking functions. Nothing runs until a limit is actually crossed.
+ * The ALERT pin can only have one function, so don't use it together with the
+ * conversion-ready acquisition or the async triggered conversions of the same device.
+ */
+
+#ifndef INA226_INA226_SUPERVISOR_H_
+#define INA226_INA226_SUPERVISOR_H_
+
+#include "INA226.h"
+
+#define INA226_SUPERVISOR_MAX_STEPS	8
+#define INA226_SUPERVISOR_STAY		0xFF	//mNext: keep the same limit armed
+#define INA226_SUPERVISOR_STOP		0xFE	//mNext: disarm after this alert
+
+//One limit. mLimit is in the unit of the trigger (uV or uW), use INA226_Supervisor_CurrentLimit_uV
+//for over / under current limits (the INA226 compares the shunt voltage).
+typedef struct INA226_alert_step{
+	enum eAlertTrigger	mTrigger;
+	int32_t				mLimit;
+	uint8_t				mNext;		//step armed after this one fired
+} INA226_alert_step;
+
+struct INA226_supervisor;
+//Called from the interrupt with the step that fired and the cause decoded from MASK_ENABLE
+typedef void (*INA226_SupervisorCallback)(struct INA226_supervisor* aSupervisor, uint8_t aStep, enum eAlertTriggerCause aCause);
+
+typedef struct INA226_supervisor{
+	INA226*						mDevice;
+	uint8_t						mCount;
+	uint8_t						mNext[INA226_SUPERVISOR_MAX_STEPS];
+	uint16_t					mMaskEnable[INA226_SUPERVISOR_MAX_STEPS];	//encoded at init
+	uint16_t					mAlertLimit[INA226_SUPERVISOR_MAX_STEPS];
+	volatile uint8_t			mArmed;			//step currently armed, INA226_SUPERVISOR_STOP if none
+	uint8_t						mArming;		//step being written by the interrupt
+	volatile bool				mPending;		//alert not serviced yet: the bus was busy or the cause read failed
+	uint8_t						mFailures;		//failed cause reads in a row
+	INA226_SupervisorCallback	mOnAlert;
+	volatile uint32_t			mAlerts;
+	volatile uint32_t			mErrors;
+} INA226_supervisor;
+
+//Encodes aSteps (up to INA226_SUPERVISOR_MAX_STEPS, copied) with the scaling of aDevice.
+//All steps use the latching alert mode so no alert is missed. Sets aDevice->Async.mSupervisor.
+status	INA226_Supervisor_Init(INA226_supervisor* this, INA226* aDevice, const INA226_alert_step* aSteps, uint8_t aCount,
+			INA226_SupervisorCallback aOnAlert);
+//Arms aStep from task context (blocking writes), e.g. when the application changes between idle
+//and active. Returns INA226_BUSY while the interrupt is using the bus.
+status	INA226_Supervisor_Arm(INA226_supervisor* this, uint8_t aStep);
+status	INA226_Supervisor_Disarm(INA226_supervisor* this);
+//Call from the EXTI handler of the ALERT pin (falling edge)
+void	INA226_Supervisor_AlertISR(INA226_supervisor* this);
+//Services an alert that arrived while the bus was busy or whose cause read failed (retried from the
+//error interrupt a few times, then only from here). Call periodically or after other transfers.
+void	INA226_Supervisor_Poll(INA226_supervisor* this);
+
+//Shunt voltage limit for a current limit, with the calibration of aConfig
+int32_t	INA226_Supervisor_CurrentLimit_uV(const INA226_config* aConfig, int32_t aCurrent_uA);
+
+#endif /* INA226_INA226_SUPERVISOR_H_ */
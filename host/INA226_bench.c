@@ -0,0 +1,368 @@
+/*
+ * INA226_bench.c
+ *
+ * Host micro-benchmarks of the driver against the simulated bus (INA226_mock.h).
+ * For every call: I2C transactions, bytes on the wire and CPU cycles (TSC on x86,
+ * nanoseconds elsewhere). Transactions and bytes are exact, so a change that adds a bus
+ * access shows up here even if it's invisible in the timing.
+ */
+
+#include "INA226.h"
+#include "INA226_mock.h"
+#include "INA226_ring.h"
+#include "INA226_dsp.h"
+#include "INA226_energy.h"
+#include "INA226_static.h"
+#include "INA226_capture.h"
+#include "INA226_delta.h"
+#include "INA226_record.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT	"cycles"
+static uint64_t Bench_Now(void)
+{
+	return __rdtsc();
+}
+#else
+#include <time.h>
+#define BENCH_UNIT	"ns"
+static uint64_t Bench_Now(void)
+{
+	struct timespec theTime;
+	clock_gettime(CLOCK_MONOTONIC, &theTime);
+	return (uint64_t)theTime.tv_sec * 1000000000u + (uint64_t)theTime.tv_nsec;
+}
+#endif
+
+extern INA226_mock gINA226_HostBus;
+
+#define BENCH_SHUNT_UOHMS	100000	//0.1 Ohm
+#define BENCH_MAX_UA		3276700
+#define BENCH_BATCH			4096
+
+INA226_DEFINE_STATIC(BenchStatic, INA226_ADRESS_0, BENCH_SHUNT_UOHMS, BENCH_MAX_UA, 0x4527);
+
+static INA226 gDevice;
+static INA226 gDevices[INA226_MOCK_MAX_DEVICES];
+static INA226_raw gRaw[BENCH_BATCH];
+static INA226_result gResults[BENCH_BATCH];
+static int16_t gCurrent[BENCH_BATCH];
+static uint16_t gPower[BENCH_BATCH];
+static INA226_sample gSamples[BENCH_BATCH];
+INA226_RING_DEFINE(gRing, BENCH_BATCH);
+static INA226_energy gEnergy;
+static INA226_capture gCapture;
+static int16_t gCaptureBuffer[BENCH_BATCH];
+static INA226_delta gDelta;
+static uint8_t gDeltaBuffer[BENCH_BATCH * INA226_DELTA_MAX_RECORD];
+static volatile int32_t gSink;
+
+//----------------------------------------------------------------------------
+static void Bench_Run(const char* aName, uint32_t aIterations, uint32_t aItemsPerCall, void (*aCall)(void))
+{
+	aCall(); //warm up, also skips one-time work (e.g. the first pointer write)
+	INA226_Mock_ResetCounters(&gINA226_HostBus);
+	uint64_t theStart = Bench_Now();
+	for(uint32_t i = 0; i < aIterations; i++){
+		aCall();
+	}
+	uint64_t theTime = Bench_Now() - theStart;
+	double theCalls = (double)aIterations;
+	printf("%-56s %8.2f %8.2f %12.1f", aName,
+		gINA226_HostBus.mTransactions / theCalls, gINA226_HostBus.mBytes / theCalls, theTime / theCalls);
+	if(aItemsPerCall > 1){
+		printf(" %10.2f", theTime / (theCalls * aItemsPerCall));
+	}
+	printf("\n");
+}
+
+static void Bench_Setup(void)
+{
+	INA226_Mock_Init(&gINA226_HostBus);
+	for(uint8_t i = 0; i < 4; i++){
+		INA226_Mock_AddDevice(&gINA226_HostBus, INA226_ADRESS_0 + i);
+		INA226_Mock_SetInput(&gINA226_HostBus, INA226_ADRESS_0 + i, 12345, 12000000);
+	}
+	if(INA226_InitFixedPoint(&gDevice, NULL, NULL, INA226_ADRESS_0, BENCH_SHUNT_UOHMS, BENCH_MAX_UA) != OK){
+		printf("INA226_InitFixedPoint failed\n");
+		exit(1);
+	}
+	srand(1);
+	for(uint32_t i = 0; i < BENCH_BATCH; i++){
+		gRaw[i].ShuntVoltage = (int16_t)(rand() % 8000 - 1000);
+		gRaw[i].BusVoltage = (uint16_t)(9600 + rand() % 100);
+		gRaw[i].Current = gRaw[i].ShuntVoltage;
+		gRaw[i].Power = (uint16_t)(rand() % 20000);
+		gSamples[i].Timestamp = i * 1000;
+		gSamples[i].Raw = gRaw[i];
+	}
+	INA226_Dsp_Deinterleave(gRaw, BENCH_BATCH, NULL, NULL, gPower, gCurrent);
+	INA226_Energy_Init(&gEnergy, &gDevice.Config);
+	INA226_Delta_Init(&gDelta, &gDevice.Config, 25, 5000, 100000, 2000, 1000000);
+}
+//----------------------------------------------------------------------------
+//Initialization
+
+static void Bench_InitFixedPoint(void)
+{
+	INA226_InitFixedPoint(&gDevice, NULL, NULL, INA226_ADRESS_0, BENCH_SHUNT_UOHMS, BENCH_MAX_UA);
+}
+
+#ifndef INA226_NO_FLOAT
+static void Bench_Init(void)
+{
+	INA226_Init(&gDevice, NULL, INA226_ADRESS_0, 0.1, 3.2767);
+}
+#endif
+
+static void Bench_InitStatic(void)
+{
+	BenchStatic_Init(&gDevice, NULL, NULL);
+}
+
+static void Bench_Enumerate(void)
+{
+	uint8_t theFound;
+	INA226_Enumerate(gDevices, INA226_MOCK_MAX_DEVICES, NULL, NULL, BENCH_SHUNT_UOHMS, BENCH_MAX_UA, &theFound);
+}
+//----------------------------------------------------------------------------
+//Measurements
+
+static void Bench_GetCurrent(void)
+{
+	gSink = INA226_GetCurrent_uA(&gDevice);
+}
+
+static void Bench_GetAll(void)
+{
+	gSink = INA226_GetShuntVoltage_uV(&gDevice) + INA226_GetBusVoltage_uV(&gDevice) +
+		INA226_GetCurrent_uA(&gDevice) + INA226_GetPower_uW(&gDevice);
+}
+
+static void Bench_MeasureAll(void)
+{
+	INA226_MeasureAll(&gDevice);
+}
+
+static void Bench_MeasureCurrent(void)
+{
+	INA226_Measure(&gDevice, MeasureCurrent);
+}
+
+static void Bench_MeasureRaw(void)
+{
+	INA226_raw theRaw;
+	INA226_MeasureRaw(&gDevice, MeasureEverything, &theRaw);
+}
+
+static void Bench_StaticMeasureAll(void)
+{
+	BenchStatic_MeasureAll(&gDevice);
+}
+
+static void Bench_MeasureAllAsync(void)
+{
+	INA226_MeasureAllAsync(&gDevice, NULL);
+	INA226_Mock_Complete(&gINA226_HostBus, &gDevice);
+}
+
+static void Bench_TriggerAndRead(void)
+{
+	INA226_TriggerAndRead(&gDevice, ShuntAndBusTriggered, MeasureCurrent | MeasureBusVoltage, NULL);
+}
+
+//The mock has no ALERT pin, both pacings are driven the same way
+static void Bench_CaptureSample(void)
+{
+	INA226_Capture_Tick(&gCapture);
+	while(INA226_Mock_TakePending(&gINA226_HostBus)){
+		INA226_Capture_TransferComplete(&gCapture);
+	}
+}
+
+static void Bench_Capture(const char* aName, enum eCapturePacing aPacing)
+{
+	INA226_SetOperatingMode(&gDevice.Config, ShuntAndBusVoltageContinuous);
+	if(INA226_Capture_Start(&gCapture, &gDevice, INA226_SHUNT_VOLTAGE_REG, aPacing, gCaptureBuffer, BENCH_BATCH, NULL, NULL, NULL) != OK){
+		printf("INA226_Capture_Start failed\n");
+		exit(1);
+	}
+	Bench_Run(aName, 10000, 1, Bench_CaptureSample);
+	INA226_Capture_Stop(&gCapture);
+}
+//----------------------------------------------------------------------------
+//Configuration
+
+static void Bench_SetOperatingMode(void)
+{
+	INA226_SetOperatingMode(&gDevice.Config, ShuntAndBusVoltageContinuous);
+}
+
+static void Bench_HibernateWakeup(void)
+{
+	INA226_Hibernate(&gDevice.Config);
+	INA226_Wakeup(&gDevice.Config);
+}
+
+static void Bench_ConfigureAlertPinTrigger(void)
+{
+	INA226_ConfigureAlertPinTrigger(&gDevice.Config, ShuntVoltageOverLimit, 50000, false);
+}
+
+static void Bench_ResetAlertPin(void)
+{
+	enum eAlertTriggerCause theCause;
+	INA226_ResetAlertPin(&gDevice.Config, &theCause);
+}
+
+static void Bench_ConfigureVoltageConversionTime(void)
+{
+	INA226_ConfigureVoltageConversionTime(&gDevice.Config, 4);
+}
+
+static void Bench_ConfigureNumSampleAveraging(void)
+{
+	INA226_ConfigureNumSampleAveraging(&gDevice.Config, 2);
+}
+
+static void Bench_ConfigureConversionTimes(void)
+{
+	INA226_ConfigureConversionTimes(&gDevice.Config, 4, 4);
+}
+
+static void Bench_Configure(void)
+{
+	static const INA226_settings cSettings = {2, 4, 4, ShuntAndBusVoltageContinuous};
+	INA226_Configure(&gDevice.Config, &cSettings);
+}
+
+static void Bench_GetSettings(void)
+{
+	INA226_settings theSettings;
+	INA226_GetSettings(&gDevice.Config, &theSettings);
+}
+//----------------------------------------------------------------------------
+//Batch paths, no bus access
+
+static void Bench_ConvertRawBatch(void)
+{
+	INA226_ConvertRawBatch(&gDevice.Config, gRaw, gResults, BENCH_BATCH);
+}
+
+static void Bench_Stats_s16(void)
+{
+	INA226_rawstats theStats;
+	INA226_Dsp_Stats_s16(gCurrent, BENCH_BATCH, &theStats);
+	gSink = (int32_t)theStats.Sum;
+}
+
+static void Bench_WindowStats(void)
+{
+	INA226_window theWindow;
+	INA226_Dsp_WindowStats(&gDevice.Config, gCurrent, gPower, BENCH_BATCH, 2200, &theWindow);
+	gSink = theWindow.CurrentMean_uA;
+}
+
+static void Bench_RingPushPop(void)
+{
+	for(uint32_t i = 0; i < BENCH_BATCH; i++){
+		INA226_Ring_Push(&gRing, &gSamples[i]);
+	}
+	INA226_Ring_PopBatch(&gRing, gSamples, BENCH_BATCH);
+}
+
+static void Bench_EnergyAdd(void)
+{
+	INA226_Energy_AddSamples(&gEnergy, gSamples, BENCH_BATCH);
+}
+
+static void Bench_RecordPack(void)
+{
+	uint32_t thePacked = 0;
+	uint32_t theSize = 0;
+	while(thePacked < BENCH_BATCH){
+		uint32_t theCount;
+		theSize += INA226_Record_Pack(&gDevice.Config, INA226_ADRESS_0, &gSamples[thePacked], BENCH_BATCH - thePacked,
+			gDeltaBuffer, INA226_RECORD_MAX_BLOCK, &theCount);
+		thePacked += theCount;
+	}
+	gSink = (int32_t)theSize;
+}
+
+static void Bench_DeltaEncode(void)
+{
+	INA226_Delta_Reset(&gDelta);
+	gSink = (int32_t)INA226_Delta_Encode(&gDelta, gSamples, BENCH_BATCH, gDeltaBuffer, sizeof(gDeltaBuffer), NULL);
+}
+//----------------------------------------------------------------------------
+static void Bench_Configuration(const char* aSuffix)
+{
+	char theName[64];
+	struct { const char* mName; void (*mCall)(void); } const cCalls[] = {
+		{"INA226_SetOperatingMode",					Bench_SetOperatingMode},
+		{"INA226_Hibernate + INA226_Wakeup",		Bench_HibernateWakeup},
+		{"INA226_ConfigureAlertPinTrigger",			Bench_ConfigureAlertPinTrigger},
+		{"INA226_ResetAlertPin",					Bench_ResetAlertPin},
+		{"INA226_ConfigureVoltageConversionTime",	Bench_ConfigureVoltageConversionTime},
+		{"INA226_ConfigureNumSampleAveraging",		Bench_ConfigureNumSampleAveraging},
+		{"INA226_ConfigureConversionTimes",			Bench_ConfigureConversionTimes},
+		{"INA226_Configure",						Bench_Configure},
+		{"INA226_GetSettings",						Bench_GetSettings},
+	};
+	for(size_t i = 0; i < sizeof(cCalls) / sizeof(cCalls[0]); i++){
+		snprintf(theName, sizeof(theName), "%s%s", cCalls[i].mName, aSuffix);
+		Bench_Run(theName, 10000, 1, cCalls[i].mCall);
+	}
+}
+
+int main(void)
+{
+	Bench_Setup();
+	printf("%-56s %8s %8s %12s %10s\n", "call", "i2c/call", "B/call", BENCH_UNIT "/call", BENCH_UNIT "/item");
+
+	Bench_Run("INA226_InitFixedPoint", 1000, 1, Bench_InitFixedPoint);
+#ifndef INA226_NO_FLOAT
+	Bench_Run("INA226_Init", 1000, 1, Bench_Init);
+#endif
+	Bench_Run("INA226_InitPrecomputed (INA226_static.h)", 1000, 1, Bench_InitStatic);
+	Bench_Run("INA226_Enumerate (4 devices)", 100, 1, Bench_Enumerate);
+
+	Bench_Run("INA226_GetCurrent_uA", 10000, 1, Bench_GetCurrent);
+	Bench_Run("INA226_Get... (all four)", 10000, 1, Bench_GetAll);
+	Bench_Run("INA226_MeasureAll", 10000, 1, Bench_MeasureAll);
+	Bench_Run("INA226_Measure(MeasureCurrent)", 10000, 1, Bench_MeasureCurrent);
+	Bench_Run("INA226_MeasureRaw", 10000, 1, Bench_MeasureRaw);
+	Bench_Run("BenchStatic_MeasureAll (INA226_static.h)", 10000, 1, Bench_StaticMeasureAll);
+	Bench_Run("INA226_MeasureAllAsync", 10000, 1, Bench_MeasureAllAsync);
+	Bench_Run("INA226_TriggerAndRead", 10000, 1, Bench_TriggerAndRead);
+	INA226_SetStreamingReads(&gDevice.Config, true);
+	Bench_Run("INA226_GetCurrent_uA (streaming reads)", 10000, 1, Bench_GetCurrent);
+	Bench_Run("INA226_MeasureAll (streaming reads)", 10000, 1, Bench_MeasureAll);
+	INA226_SetStreamingReads(&gDevice.Config, false);
+	Bench_Capture("INA226_Capture sample (timer paced)", CapturePacedByTimer);
+	Bench_Capture("INA226_Capture sample (conversion ready paced)", CapturePacedByConversionReady);
+
+	Bench_Configuration("");
+	INA226_SetTrustCache(&gDevice.Config, true);
+	Bench_Configuration(" (trusted cache)");
+	INA226_SetTrustCache(&gDevice.Config, false);
+
+	Bench_Run("INA226_ConvertRawBatch", 1000, BENCH_BATCH, Bench_ConvertRawBatch);
+	Bench_Run("INA226_Dsp_Stats_s16", 1000, BENCH_BATCH, Bench_Stats_s16);
+	Bench_Run("INA226_Dsp_WindowStats", 1000, BENCH_BATCH, Bench_WindowStats);
+	Bench_Run("INA226_Ring_Push + INA226_Ring_PopBatch", 1000, BENCH_BATCH, Bench_RingPushPop);
+	Bench_Run("INA226_Energy_AddSamples", 1000, BENCH_BATCH, Bench_EnergyAdd);
+	Bench_Run("INA226_Record_Pack", 1000, BENCH_BATCH, Bench_RecordPack);
+	Bench_Run("INA226_Delta_Encode (random samples)", 1000, BENCH_BATCH, Bench_DeltaEncode);
+#ifdef INA226_TRACE
+	const INA226_stats* theStats = &gDevice.Config.mStats;
+	printf("\nINA226_TRACE: %u transactions, %u bytes, %u errors, %u timeouts, %u retries, worst %u (event %u, register 0x%02X)\n",
+		theStats->mTransactions, theStats->mBytes, theStats->mErrors, theStats->mTimeouts, theStats->mRetries,
+		theStats->mWorstCycles, theStats->mWorstEvent, theStats->mWorstRegister);
+#endif
+	return 0;
+}
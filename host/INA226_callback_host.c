@@ -0,0 +1,24 @@
+/*
+ * INA226_callback_host.c
+ *
+ * Host replacement of INA226_callback.c: the default transport is the simulated bus
+ * gINA226_HostBus, so INA226_Init works unchanged off-target.
+ */
+
+#include "INA226.h"
+#include "INA226_callback.h"
+#include "INA226_mock.h"
+
+//Call INA226_Mock_Init(&gINA226_HostBus) and INA226_Mock_AddDevice(..) before INA226_Init
+INA226_mock gINA226_HostBus;
+
+const INA226_transport INA226_DefaultTransport = {
+	.Transmit			= INA226_Mock_Transmit,
+	.Receive			= INA226_Mock_Receive,
+	.WriteRead			= INA226_Mock_WriteRead,
+	.Check_device		= INA226_Mock_CheckDevice,
+	.Transmit_Async		= INA226_Mock_TransmitAsync,
+	.Receive_Async		= INA226_Mock_ReceiveAsync,
+	.ReadRegister_Async	= INA226_Mock_ReadRegisterAsync,
+	.Context			= &gINA226_HostBus,
+};
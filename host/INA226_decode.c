@@ -0,0 +1,64 @@
+/*
+ * INA226_decode.c
+ *
+ * Host decoder of the packed sample blocks of INA226_record.h: reads a stream of blocks
+ * (e.g. a capture of the telemetry link) from stdin, prints CSV in micro units.
+ *   ina226_decode < capture.bin > samples.csv
+ */
+
+#include "INA226.h"
+#include "INA226_record.h"
+#include <stdio.h>
+#include <string.h>
+
+int main(void)
+{
+	static uint8_t theBuffer[4 * INA226_RECORD_MAX_BLOCK];
+	INA226_sample theSamples[INA226_RECORD_MAX_COUNT];
+	INA226_result theResults[INA226_RECORD_MAX_COUNT];
+	INA226_config theScaling;
+	memset(&theScaling, 0, sizeof(theScaling));
+	uint32_t theFill = 0;
+	uint32_t theSkipped = 0;
+
+	printf("device,timestamp_us,shunt_uV,bus_uV,current_uA,power_uW,config_hash\n");
+	for(;;){
+		size_t theRead = fread(theBuffer + theFill, 1, sizeof(theBuffer) - theFill, stdin);
+		theFill += (uint32_t)theRead;
+		uint32_t thePos = 0;
+		while(thePos < theFill){
+			INA226_record_header theHeader;
+			uint32_t theBlockSize = 0;
+			status s = INA226_Record_ParseHeader(theBuffer + thePos, theFill - thePos, &theHeader, &theBlockSize);
+			bool theIncomplete = theFill - thePos < INA226_RECORD_HEADER_SIZE || theFill - thePos < theBlockSize;
+			if(s != OK && theIncomplete && theRead != 0){
+				break; //wait for the rest of the block
+			}
+			if(s != OK){
+				thePos++; //resynchronise on the next magic byte
+				theSkipped++;
+				continue;
+			}
+			uint32_t theCount = INA226_Record_Unpack(&theHeader, theBuffer + thePos, theSamples, INA226_RECORD_MAX_COUNT);
+			INA226_Record_Scaling(&theHeader, &theScaling);
+			for(uint32_t i = 0; i < theCount; i++){
+				INA226_ConvertRawBatch(&theScaling, &theSamples[i].Raw, &theResults[i], 1);
+			}
+			for(uint32_t i = 0; i < theCount; i++){
+				printf("%u,%u,%d,%d,%d,%d,0x%04X\n", theHeader.mDeviceId, theSamples[i].Timestamp,
+					theResults[i].ShuntVoltage_uV, theResults[i].BusVoltage_uV, theResults[i].Current_uA, theResults[i].Power_uW,
+					theHeader.mConfigHash);
+			}
+			thePos += theBlockSize;
+		}
+		memmove(theBuffer, theBuffer + thePos, theFill - thePos);
+		theFill -= thePos;
+		if(theRead == 0){
+			break;
+		}
+	}
+	if(theSkipped != 0){
+		fprintf(stderr, "%u bytes skipped\n", theSkipped);
+	}
+	return 0;
+}
@@ -0,0 +1,281 @@
+/*
+ * INA226_mock.c
+ *
+ * Simulated INA226 register files, see INA226_mock.h
+ */
+
+#include "INA226_mock.h"
+#include <stddef.h>
+#include <string.h>
+
+static const uint16_t cMockConfigReset    = 0x4127;
+static const uint16_t cMockManufacturerId = 0x5449;
+static const uint16_t cMockDieId          = 0x2260;
+static const uint16_t cMockConversionReady = 0x0008;
+static const uint16_t cMockAlertFlags     = 0x001C; //AFF, CVRF, OVF, cleared by reading MASK_ENABLE
+static const uint16_t cMockWritableMask   = 0xFC03;
+
+//----------------------------------------------------------------------------
+static INA226_mock* INA226_Mock_Of(INA226_config* aConfig)
+{
+	return (INA226_mock*)aConfig->mTransport->Context;
+}
+
+static INA226_mock_device* INA226_Mock_At(INA226_mock* this, uint8_t aI2C_Address)
+{
+	if(aI2C_Address < INA226_ADRESS_0 || aI2C_Address > INA226_ADRESS_15){
+		return NULL;
+	}
+	INA226_mock_device* theDevice = &this->mDevices[aI2C_Address - INA226_ADRESS_0];
+	return theDevice->mPresent ? theDevice : NULL;
+}
+
+//True if this transaction is one of the failures of INA226_Mock_FailTransactions
+static bool INA226_Mock_Inject(INA226_mock* this)
+{
+	if(this->mFailCount == 0){
+		return false;
+	}
+	if(this->mFailAfter > 0){
+		this->mFailAfter--;
+		return false;
+	}
+	this->mFailCount--;
+	return true;
+}
+
+static void INA226_Mock_PowerOn(INA226_mock_device* aDevice)
+{
+	memset(aDevice->mRegisters, 0, sizeof(aDevice->mRegisters));
+	aDevice->mRegisters[INA226_CONFIG_REG] = cMockConfigReset;
+	aDevice->mPointer = 0;
+}
+
+//Register content as the device would return it
+static uint16_t INA226_Mock_Read(INA226_mock_device* aDevice, uint8_t aRegister)
+{
+	switch(aRegister){
+	case INA226_SHUNT_VOLTAGE_REG:
+		return (uint16_t)aDevice->mShuntRaw;
+	case INA226_BUS_VOLTAGE_REG:
+		return aDevice->mBusRaw;
+	case INA226_CURRENT_REG:
+		return (uint16_t)(int16_t)(((int32_t)aDevice->mShuntRaw * aDevice->mRegisters[INA226_CALIBRATION_REG]) / 2048);
+	case INA226_POWER_REG:{
+		int32_t theCurrent = ((int32_t)aDevice->mShuntRaw * aDevice->mRegisters[INA226_CALIBRATION_REG]) / 2048;
+		if(theCurrent < 0){
+			theCurrent = -theCurrent;
+		}
+		return (uint16_t)(((uint32_t)theCurrent * aDevice->mBusRaw) / 20000);
+	}
+	case INA226_MASK_ENABLE_REG:{
+		uint16_t theValue = aDevice->mRegisters[INA226_MASK_ENABLE_REG];
+		if(aDevice->mNotReadyPolls > 0){
+			aDevice->mNotReadyPolls--;
+		}else{
+			theValue |= cMockConversionReady;
+		}
+		aDevice->mRegisters[INA226_MASK_ENABLE_REG] &= ~cMockAlertFlags;
+		return theValue;
+	}
+	case INA226_MANUFACTURER_ID_REG:
+		return cMockManufacturerId;
+	case INA226_DIE_ID_REG:
+		return cMockDieId;
+	default:
+		return aRegister < 8 ? aDevice->mRegisters[aRegister] : 0xFFFF;
+	}
+}
+
+static void INA226_Mock_Write(INA226_mock_device* aDevice, uint8_t aRegister, uint16_t aValue)
+{
+	switch(aRegister){
+	case INA226_CONFIG_REG:
+		if(aValue & 0x8000){
+			INA226_Mock_PowerOn(aDevice);
+		}else{
+			aDevice->mRegisters[INA226_CONFIG_REG] = aValue;
+		}
+		break;
+	case INA226_CALIBRATION_REG:
+		aDevice->mRegisters[INA226_CALIBRATION_REG] = aValue & 0x7FFF;
+		break;
+	case INA226_MASK_ENABLE_REG:
+		aDevice->mRegisters[INA226_MASK_ENABLE_REG] = aValue & cMockWritableMask;
+		break;
+	case INA226_ALERT_LIMIT_REG:
+		aDevice->mRegisters[INA226_ALERT_LIMIT_REG] = aValue;
+		break;
+	default:
+		break; //read only
+	}
+}
+//----------------------------------------------------------------------------
+void INA226_Mock_Init(INA226_mock* this)
+{
+	memset(this, 0, sizeof(*this));
+	this->mTransport.Transmit = INA226_Mock_Transmit;
+	this->mTransport.Receive = INA226_Mock_Receive;
+	this->mTransport.WriteRead = INA226_Mock_WriteRead;
+	this->mTransport.Check_device = INA226_Mock_CheckDevice;
+	this->mTransport.Transmit_Async = INA226_Mock_TransmitAsync;
+	this->mTransport.Receive_Async = INA226_Mock_ReceiveAsync;
+	this->mTransport.ReadRegister_Async = INA226_Mock_ReadRegisterAsync;
+	this->mTransport.Context = this;
+}
+//----------------------------------------------------------------------------
+void INA226_Mock_AddDevice(INA226_mock* this, uint8_t aI2C_Address)
+{
+	if(aI2C_Address < INA226_ADRESS_0 || aI2C_Address > INA226_ADRESS_15){
+		return;
+	}
+	INA226_mock_device* theDevice = &this->mDevices[aI2C_Address - INA226_ADRESS_0];
+	memset(theDevice, 0, sizeof(*theDevice));
+	theDevice->mPresent = true;
+	INA226_Mock_PowerOn(theDevice);
+}
+//----------------------------------------------------------------------------
+void INA226_Mock_SetInput(INA226_mock* this, uint8_t aI2C_Address, int32_t aShunt_uV, int32_t aBus_uV)
+{
+	INA226_mock_device* theDevice = INA226_Mock_At(this, aI2C_Address);
+	if(theDevice == NULL){
+		return;
+	}
+	theDevice->mShuntRaw = (int16_t)((aShunt_uV * 2) / 5);	//2.5uV per bit
+	theDevice->mBusRaw = (uint16_t)(aBus_uV / 1250);		//1.25mV per bit
+}
+//----------------------------------------------------------------------------
+INA226_mock_device* INA226_Mock_Device(INA226_mock* this, uint8_t aI2C_Address)
+{
+	return INA226_Mock_At(this, aI2C_Address);
+}
+//----------------------------------------------------------------------------
+void INA226_Mock_ResetCounters(INA226_mock* this)
+{
+	this->mTransactions = 0;
+	this->mBytes = 0;
+	this->mFailures = 0;
+}
+//----------------------------------------------------------------------------
+void INA226_Mock_FailTransactions(INA226_mock* this, uint32_t aAfter, uint32_t aCount)
+{
+	this->mFailAfter = aAfter;
+	this->mFailCount = aCount;
+}
+//----------------------------------------------------------------------------
+//Transactions, START + address byte + data bytes
+int INA226_Mock_Transmit(INA226_config* this, uint8_t* aData, uint16_t Size)
+{
+	INA226_mock* theMock = INA226_Mock_Of(this);
+	INA226_mock_device* theDevice = INA226_Mock_At(theMock, this->mI2C_Address);
+	theMock->mTransactions++;
+	theMock->mBytes += 1;
+	if(theDevice == NULL || INA226_Mock_Inject(theMock)){
+		theMock->mFailures++;
+		return -1;
+	}
+	theMock->mBytes += Size;
+	if(Size >= 1){
+		theDevice->mPointer = aData[0];
+	}
+	if(Size >= 3){
+		INA226_Mock_Write(theDevice, aData[0], (uint16_t)aData[1] << 8 | aData[2]);
+	}
+	return 0;
+}
+
+int INA226_Mock_Receive(INA226_config* this, uint8_t* buffer, uint16_t Size)
+{
+	INA226_mock* theMock = INA226_Mock_Of(this);
+	INA226_mock_device* theDevice = INA226_Mock_At(theMock, this->mI2C_Address);
+	theMock->mTransactions++;
+	theMock->mBytes += 1;
+	if(theDevice == NULL || INA226_Mock_Inject(theMock)){
+		theMock->mFailures++;
+		return -1;
+	}
+	theMock->mBytes += Size;
+	uint16_t theValue = INA226_Mock_Read(theDevice, theDevice->mPointer);
+	for(uint16_t i = 0; i < Size; i++){
+		buffer[i] = (i & 1) ? (uint8_t)(theValue & 0xFF) : (uint8_t)(theValue >> 8);
+	}
+	return 0;
+}
+
+int INA226_Mock_WriteRead(INA226_config* this, uint8_t aRegister, uint8_t* buffer, uint16_t Size)
+{
+	INA226_mock* theMock = INA226_Mock_Of(this);
+	INA226_mock_device* theDevice = INA226_Mock_At(theMock, this->mI2C_Address);
+	theMock->mTransactions++;
+	theMock->mBytes += 1;
+	if(theDevice == NULL || INA226_Mock_Inject(theMock)){
+		theMock->mFailures++;
+		return -1;
+	}
+	//Address + register, repeated START, address + data
+	theMock->mBytes += 2 + Size;
+	theDevice->mPointer = aRegister;
+	uint16_t theValue = INA226_Mock_Read(theDevice, aRegister);
+	for(uint16_t i = 0; i < Size; i++){
+		buffer[i] = (i & 1) ? (uint8_t)(theValue & 0xFF) : (uint8_t)(theValue >> 8);
+	}
+	return 0;
+}
+
+int INA226_Mock_CheckDevice(INA226_config* this, uint8_t aI2C_Address, uint32_t Trials)
+{
+	INA226_mock* theMock = INA226_Mock_Of(this);
+	theMock->mTransactions++;
+	theMock->mBytes += 1;
+	if(INA226_Mock_At(theMock, aI2C_Address) == NULL || INA226_Mock_Inject(theMock)){
+		theMock->mFailures++;
+		return -1;
+	}
+	return 0;
+}
+//----------------------------------------------------------------------------
+int INA226_Mock_TransmitAsync(INA226_config* this, uint8_t* aData, uint16_t Size)
+{
+	int theResult = INA226_Mock_Transmit(this, aData, Size);
+	if(theResult == 0){
+		INA226_Mock_Of(this)->mPending++;
+	}
+	return theResult;
+}
+
+int INA226_Mock_ReceiveAsync(INA226_config* this, uint8_t* buffer, uint16_t Size)
+{
+	int theResult = INA226_Mock_Receive(this, buffer, Size);
+	if(theResult == 0){
+		INA226_Mock_Of(this)->mPending++;
+	}
+	return theResult;
+}
+
+int INA226_Mock_ReadRegisterAsync(INA226_config* this, uint8_t aRegister, uint8_t* buffer, uint16_t Size)
+{
+	int theResult = INA226_Mock_WriteRead(this, aRegister, buffer, Size);
+	if(theResult == 0){
+		INA226_Mock_Of(this)->mPending++;
+	}
+	return theResult;
+}
+//----------------------------------------------------------------------------
+bool INA226_Mock_TakePending(INA226_mock* this)
+{
+	if(this->mPending == 0){
+		return false;
+	}
+	this->mPending--;
+	return true;
+}
+//----------------------------------------------------------------------------
+uint32_t INA226_Mock_Complete(INA226_mock* this, INA226* aDevice)
+{
+	uint32_t theCount = 0;
+	while(INA226_Mock_TakePending(this)){
+		INA226_AsyncTransferComplete(aDevice);
+		theCount++;
+	}
+	return theCount;
+}
@@ -0,0 +1,65 @@
+/*
+ * INA226_mock.h
+ *
+ * Simulated I2C bus with up to 16 INA226 register files, behind the INA226_transport
+ * interface. Host builds only (benchmarks, off-target debugging).
+ * The current and power registers are computed from the simulated shunt / bus voltage and
+ * the calibration register like the device does. Non-blocking transfers are executed
+ * immediately but only reported when INA226_Mock_Complete is called, like a DMA transfer.
+ */
+
+#ifndef INA226_HOST_INA226_MOCK_H_
+#define INA226_HOST_INA226_MOCK_H_
+
+#include "INA226.h"
+
+#define INA226_MOCK_MAX_DEVICES	16 //INA226_ADRESS_0 .. INA226_ADRESS_15
+
+typedef struct INA226_mock_device{
+	bool		mPresent;
+	uint16_t	mRegisters[8];
+	uint8_t		mPointer;
+	int16_t		mShuntRaw;			//simulated inputs, register units
+	uint16_t	mBusRaw;
+	uint16_t	mNotReadyPolls;		//MASK_ENABLE reads before the conversion ready flag is set
+} INA226_mock_device;
+
+typedef struct INA226_mock{
+	INA226_mock_device	mDevices[INA226_MOCK_MAX_DEVICES];
+	INA226_transport	mTransport;		//points back to this mock through Context
+	uint32_t			mTransactions;	//I2C transactions (START .. STOP)
+	uint32_t			mBytes;			//bytes on the wire, address bytes included
+	uint32_t			mFailures;		//NACKs (no device at the address)
+	int					mPending;		//async transfers started but not reported yet
+	uint32_t			mFailAfter;		//transactions that still succeed before the injected failures
+	uint32_t			mFailCount;		//transactions NACKed after those, see INA226_Mock_FailTransactions
+} INA226_mock;
+
+//Clears the bus, fills mTransport with the mock functions
+void	INA226_Mock_Init(INA226_mock* this);
+//Adds a device at aI2C_Address with its power-on register values
+void	INA226_Mock_AddDevice(INA226_mock* this, uint8_t aI2C_Address);
+//Simulated inputs of a device, in micro volts
+void	INA226_Mock_SetInput(INA226_mock* this, uint8_t aI2C_Address, int32_t aShunt_uV, int32_t aBus_uV);
+INA226_mock_device* INA226_Mock_Device(INA226_mock* this, uint8_t aI2C_Address);
+void	INA226_Mock_ResetCounters(INA226_mock* this);
+//The aCount transactions after the next aAfter ones are NACKed (a device that stops answering),
+//counted in mFailures. The async functions report the failure when they are called.
+void	INA226_Mock_FailTransactions(INA226_mock* this, uint32_t aAfter, uint32_t aCount);
+
+//Delivers every pending non-blocking transfer of aDevice (INA226_AsyncTransferComplete),
+//including the ones started from the completions. Returns the number delivered.
+uint32_t INA226_Mock_Complete(INA226_mock* this, INA226* aDevice);
+//Takes one pending transfer, the caller reports it (e.g. to INA226_Bus_TransferComplete)
+bool	INA226_Mock_TakePending(INA226_mock* this);
+
+//Transport functions, also used by host/INA226_callback_host.c
+int		INA226_Mock_Transmit(INA226_config* this, uint8_t* aData, uint16_t Size);
+int		INA226_Mock_Receive(INA226_config* this, uint8_t* buffer, uint16_t Size);
+int		INA226_Mock_WriteRead(INA226_config* this, uint8_t aRegister, uint8_t* buffer, uint16_t Size);
+int		INA226_Mock_CheckDevice(INA226_config* this, uint8_t aI2C_Address, uint32_t Trials);
+int		INA226_Mock_TransmitAsync(INA226_config* this, uint8_t* aData, uint16_t Size);
+int		INA226_Mock_ReceiveAsync(INA226_config* this, uint8_t* buffer, uint16_t Size);
+int		INA226_Mock_ReadRegisterAsync(INA226_config* this, uint8_t aRegister, uint8_t* buffer, uint16_t Size);
+
+#endif /* INA226_HOST_INA226_MOCK_H_ */
@@ -0,0 +1,1013 @@
+/*
+ * INA226_test.c
+ *
+ * Host tests of the driver against the simulated bus (INA226_mock.h), run by ctest.
+ * The transactions and bytes of the mock are exact, so the tests also pin down how many
+ * bus accesses each call costs: a change that adds one fails here.
+ * ./ina226_test runs every test, ./ina226_test <name> only the ones whose name contains <name>.
+ */
+
+#include "INA226.h"
+#include "INA226_mock.h"
+#include "INA226_ring.h"
+#include "INA226_bus.h"
+#include "INA226_adaptive.h"
+#include "INA226_supervisor.h"
+#include "INA226_delta.h"
+#include "INA226_record.h"
+#include "INA226_plan.h"
+#include "INA226_capture.h"
+#include "INA226_osal.h"
+#include "INA226_energy.h"
+#include <stdio.h>
+#include <string.h>
+
+extern INA226_mock gINA226_HostBus;
+
+#define TEST_SHUNT_UOHMS	100000	//0.1 Ohm
+#define TEST_MAX_UA			3276700
+#define TEST_SHUNT_UV		12345
+#define TEST_BUS_UV			12000000
+#define TEST_SAMPLES		300
+
+static const char* gTestName;
+static uint32_t gChecks;
+static uint32_t gFailures;
+static uint32_t gNow;	//clock of the tests, microseconds
+static INA226 gDevice;
+static INA226 gDevices[4];
+static INA226_sample gSamples[TEST_SAMPLES];
+static INA226_sample gDecoded[TEST_SAMPLES];
+static uint8_t gBuffer[TEST_SAMPLES * INA226_DELTA_MAX_RECORD];
+
+#define CHECK(aCondition)				Test_Check((aCondition), #aCondition, __LINE__)
+#define CHECK_EQUAL(aValue, aExpected)	Test_CheckEqual((int64_t)(aValue), (int64_t)(aExpected), #aValue, __LINE__)
+//Bus traffic of the calls since the last INA226_Mock_ResetCounters
+#define CHECK_TRAFFIC(aTransactions, aBytes) { CHECK_EQUAL(gINA226_HostBus.mTransactions, aTransactions); \
+											   CHECK_EQUAL(gINA226_HostBus.mBytes, aBytes); }
+
+static void Test_Check(bool aPassed, const char* aText, int aLine)
+{
+	gChecks++;
+	if(!aPassed){
+		gFailures++;
+		printf("%s:%d: %s: CHECK(%s) failed\n", __FILE__, aLine, gTestName, aText);
+	}
+}
+
+static void Test_CheckEqual(int64_t aValue, int64_t aExpected, const char* aText, int aLine)
+{
+	gChecks++;
+	if(aValue != aExpected){
+		gFailures++;
+		printf("%s:%d: %s: %s is %lld, expected %lld\n", __FILE__, aLine, gTestName, aText, (long long)aValue, (long long)aExpected);
+	}
+}
+
+static uint32_t Test_Clock(void)
+{
+	return gNow;
+}
+
+//Four devices on the simulated bus, gDevice initialized at INA226_ADRESS_0
+static void Test_Setup(void)
+{
+	INA226_Mock_Init(&gINA226_HostBus);
+	for(uint8_t i = 0; i < 4; i++){
+		INA226_Mock_AddDevice(&gINA226_HostBus, INA226_ADRESS_0 + i);
+		INA226_Mock_SetInput(&gINA226_HostBus, INA226_ADRESS_0 + i, TEST_SHUNT_UV, TEST_BUS_UV);
+	}
+	gNow = 0;
+	memset(&gDevice, 0, sizeof(gDevice));
+	CHECK_EQUAL(INA226_InitFixedPoint(&gDevice, NULL, NULL, INA226_ADRESS_0, TEST_SHUNT_UOHMS, TEST_MAX_UA), OK);
+	INA226_Mock_ResetCounters(&gINA226_HostBus);
+}
+
+static INA226_mock_device* Test_MockDevice(uint8_t aIndex)
+{
+	return INA226_Mock_Device(&gINA226_HostBus, INA226_ADRESS_0 + aIndex);
+}
+
+//Slow ramp with a little noise, 1ms apart
+static void Test_FillSamples(void)
+{
+	uint32_t theNoise = 1;
+	for(uint32_t i = 0; i < TEST_SAMPLES; i++){
+		theNoise = theNoise * 1103515245u + 12345u;
+		int16_t theJitter = (int16_t)((theNoise >> 16) % 7) - 3;
+		gSamples[i].Timestamp = 5000 + i * 1000;
+		gSamples[i].Raw.ShuntVoltage = (int16_t)(4000 + i * 2 + theJitter);
+		gSamples[i].Raw.BusVoltage = (uint16_t)(9600 + i / 10);
+		gSamples[i].Raw.Power = (uint16_t)(3000 + i + theJitter);
+		gSamples[i].Raw.Current = (int16_t)(-2000 - (int16_t)i + theJitter);
+	}
+}
+//----------------------------------------------------------------------------
+//Register access
+
+static void Test_MeasureAll(void)
+{
+	Test_Setup();
+	CHECK_EQUAL(INA226_MeasureAll(&gDevice), OK);
+	CHECK_TRAFFIC(4, 20); //one write-read per register
+	CHECK_EQUAL(gDevice.Result.ShuntVoltage_uV, TEST_SHUNT_UV);
+	CHECK_EQUAL(gDevice.Result.BusVoltage_uV, TEST_BUS_UV);
+	CHECK_EQUAL(INA226_GetShuntVoltage_uV(&gDevice), TEST_SHUNT_UV);
+}
+
+static void Test_StreamingReads(void)
+{
+	Test_Setup();
+	int32_t theExpected = INA226_GetCurrent_uA(&gDevice);
+	CHECK_EQUAL(INA226_SetStreamingReads(&gDevice.Config, true), OK);
+	INA226_GetCurrent_uA(&gDevice); //moves the pointer, once
+	INA226_Mock_ResetCounters(&gINA226_HostBus);
+	CHECK_EQUAL(INA226_GetCurrent_uA(&gDevice), theExpected);
+	CHECK_TRAFFIC(1, 3); //address + 2 data bytes, the pointer is already latched
+	CHECK_EQUAL(INA226_GetCurrent_uA(&gDevice), theExpected);
+	CHECK_TRAFFIC(2, 6);
+}
+
+static void Test_TrustedCacheConfigWrite(void)
+{
+	Test_Setup();
+	CHECK_EQUAL(INA226_SetOperatingMode(&gDevice.Config, ShuntAndBusVoltageContinuous), OK);
+	CHECK_TRAFFIC(2, 9); //read-modify-write
+	CHECK_EQUAL(INA226_SetTrustCache(&gDevice.Config, true), OK);
+	INA226_Mock_ResetCounters(&gINA226_HostBus);
+	CHECK_EQUAL(INA226_SetOperatingMode(&gDevice.Config, ShuntVoltageContinuous), OK);
+	CHECK_TRAFFIC(1, 4); //the write only
+	CHECK_EQUAL(Test_MockDevice(0)->mRegisters[INA226_CONFIG_REG], gDevice.Config.mConfigRegister);
+	CHECK_EQUAL(gDevice.Config.mConfigRegister & 7, ShuntVoltageContinuous);
+	INA226_settings theSettings;
+	INA226_Mock_ResetCounters(&gINA226_HostBus);
+	CHECK_EQUAL(INA226_GetSettings(&gDevice.Config, &theSettings), OK);
+	CHECK_TRAFFIC(0, 0);
+	CHECK_EQUAL(theSettings.mOperatingMode, ShuntVoltageContinuous);
+}
+
+static void Test_ConfigureAlertPinTrigger(void)
+{
+	Test_Setup();
+	CHECK_EQUAL(INA226_ConfigureAlertPinTrigger(&gDevice.Config, ShuntVoltageOverLimit, 50000, false), OK);
+	CHECK_TRAFFIC(3, 13); //MASK_ENABLE read, limit write, MASK_ENABLE write
+	CHECK_EQUAL(INA226_SetTrustCache(&gDevice.Config, true), OK);
+	INA226_Mock_ResetCounters(&gINA226_HostBus);
+	CHECK_EQUAL(INA226_ConfigureAlertPinTrigger(&gDevice.Config, ShuntVoltageOverLimit, 50000, false), OK);
+	CHECK_TRAFFIC(2, 8);
+	CHECK_EQUAL(Test_MockDevice(0)->mRegisters[INA226_ALERT_LIMIT_REG], 50000 * 2 / 5);
+	CHECK_EQUAL(Test_MockDevice(0)->mRegisters[INA226_MASK_ENABLE_REG] & 0xFC00, ShuntVoltageOverLimit);
+
+	//No scaling before the initialization
+	INA226_config theUninitialized;
+	memset(&theUninitialized, 0, sizeof(theUninitialized));
+	uint16_t theMaskEnable;
+	uint16_t theAlertLimit;
+	CHECK_EQUAL(INA226_EncodeAlertTrigger(&theUninitialized, PowerOverLimit, 1000000, false, &theMaskEnable, &theAlertLimit), NOT_INITIALIZED);
+	CHECK_EQUAL(INA226_EncodeAlertTrigger(&gDevice.Config, PowerOverLimit, 1000000, false, &theMaskEnable, &theAlertLimit), OK);
+	CHECK_EQUAL(theAlertLimit, 1000000 / gDevice.Config.mPowerMicroWattPerBit);
+}
+
+static void Test_Enumerate(void)
+{
+	Test_Setup();
+	uint8_t theFound;
+	CHECK_EQUAL(INA226_Enumerate(gDevices, 4, NULL, NULL, TEST_SHUNT_UOHMS, TEST_MAX_UA, &theFound), OK);
+	CHECK_EQUAL(theFound, 4);
+	CHECK_TRAFFIC(28, 112);
+
+	//The reset of the second device fails (4 probes and 8 ID reads before): the others are initialized
+	INA226_Mock_FailTransactions(&gINA226_HostBus, 13, 1);
+	CHECK_EQUAL(INA226_Enumerate(gDevices, 4, NULL, NULL, TEST_SHUNT_UOHMS, TEST_MAX_UA, &theFound), OK);
+	CHECK_EQUAL(theFound, 3);
+	const uint8_t cAddresses[3] = {INA226_ADRESS_0, INA226_ADRESS_0 + 2, INA226_ADRESS_0 + 3};
+	for(uint8_t i = 0; i < 3; i++){
+		CHECK_EQUAL(gDevices[i].Config.mI2C_Address, cAddresses[i]);
+		CHECK(gDevices[i].Config.mInitialized);
+		CHECK_EQUAL(Test_MockDevice(cAddresses[i] - INA226_ADRESS_0)->mRegisters[INA226_CALIBRATION_REG], gDevices[i].Config.mCalibrationValue);
+	}
+	CHECK(!gDevices[3].Config.mInitialized);
+}
+
+static void Test_MeasureAsync(void)
+{
+	Test_Setup();
+	CHECK_EQUAL(INA226_MeasureAllAsync(&gDevice, NULL), OK);
+	CHECK(INA226_AsyncIsBusy(&gDevice));
+	CHECK_EQUAL(INA226_MeasureAllAsync(&gDevice, NULL), INA226_BUSY);
+	CHECK_EQUAL(INA226_Mock_Complete(&gINA226_HostBus, &gDevice), 4);
+	CHECK(!INA226_AsyncIsBusy(&gDevice));
+	CHECK_TRAFFIC(4, 20);
+	CHECK_EQUAL(gDevice.Result.ShuntVoltage_uV, TEST_SHUNT_UV);
+	CHECK_EQUAL(gDevice.Result.BusVoltage_uV, TEST_BUS_UV);
+}
+//Power cycle: the device is back with its power-on values, the restore fails on the calibration
+static void Test_Reprobe(void)
+{
+	Test_Setup();
+	uint16_t theConfig = gDevice.Config.mConfigRegister;
+	uint16_t theCalibration = gDevice.Config.mCalibrationValue;
+	CHECK(theCalibration != 0);
+	INA226_Mock_AddDevice(&gINA226_HostBus, INA226_ADRESS_0);
+	INA226_Mock_FailTransactions(&gINA226_HostBus, 4, 1);
+	CHECK_EQUAL(INA226_Reprobe(&gDevice.Config), FAIL);
+	CHECK_EQUAL(gDevice.Config.mCalibrationValue, theCalibration);
+	CHECK_EQUAL(Test_MockDevice(0)->mRegisters[INA226_CALIBRATION_REG], 0);
+	CHECK_EQUAL(INA226_Reprobe(&gDevice.Config), OK);
+	CHECK_EQUAL(Test_MockDevice(0)->mRegisters[INA226_CALIBRATION_REG], theCalibration);
+	CHECK_EQUAL(Test_MockDevice(0)->mRegisters[INA226_CONFIG_REG], theConfig);
+	INA226_Mock_ResetCounters(&gINA226_HostBus);
+	CHECK_EQUAL(INA226_Reprobe(&gDevice.Config), OK);
+	CHECK_TRAFFIC(1, 5); //healthy: the read only
+
+	INA226_Mock_AddDevice(&gINA226_HostBus, INA226_ADRESS_0);
+	INA226_Mock_FailTransactions(&gINA226_HostBus, 4, 1);
+	CHECK_EQUAL(INA226_ReprobeAsync(&gDevice, NULL), OK);
+	INA226_Mock_Complete(&gINA226_HostBus, &gDevice);
+	CHECK(!INA226_AsyncIsBusy(&gDevice));
+	CHECK_EQUAL(gDevice.Config.mCalibrationValue, theCalibration);
+	CHECK_EQUAL(gDevice.Config.mConfigRegister, theConfig);
+	CHECK_EQUAL(INA226_ReprobeAsync(&gDevice, NULL), OK);
+	INA226_Mock_Complete(&gINA226_HostBus, &gDevice);
+	CHECK_EQUAL(Test_MockDevice(0)->mRegisters[INA226_CALIBRATION_REG], theCalibration);
+	CHECK_EQUAL(Test_MockDevice(0)->mRegisters[INA226_CONFIG_REG], theConfig);
+}
+
+static void Test_AlertOverrun(void)
+{
+	Test_Setup();
+	CHECK_EQUAL(INA226_StartConversionReadyAcquisition(&gDevice, MeasureCurrent, NULL, NULL), OK);
+	INA226_Mock_ResetCounters(&gINA226_HostBus);
+	INA226_AlertPinISR(&gDevice);
+	INA226_AlertPinISR(&gDevice); //the next conversion, the first read is still running
+	CHECK_EQUAL(gDevice.Acquisition.mOverruns, 1);
+	CHECK(gDevice.Acquisition.mAlertPending);
+	INA226_Mock_Complete(&gINA226_HostBus, &gDevice);
+	//The second conversion is read (and the pin released) at the end of the first read
+	CHECK(!gDevice.Acquisition.mAlertPending);
+	CHECK(!INA226_AsyncIsBusy(&gDevice));
+	CHECK_EQUAL(gDevice.Acquisition.mSamples, 2);
+	CHECK_TRAFFIC(4, 20); //MASK_ENABLE and current, twice
+}
+
+static void Test_AlertReadFailure(void)
+{
+	Test_Setup();
+	CHECK_EQUAL(INA226_StartConversionReadyAcquisition(&gDevice, MeasureCurrent, NULL, NULL), OK);
+
+	//A read that fails in the middle is retried from the completion
+	INA226_Mock_FailTransactions(&gINA226_HostBus, 1, 1);
+	INA226_AlertPinISR(&gDevice);
+	INA226_Mock_Complete(&gINA226_HostBus, &gDevice);
+	CHECK_EQUAL(gDevice.Acquisition.mErrors, 1);
+	CHECK_EQUAL(gDevice.Acquisition.mSamples, 1);
+	CHECK(!gDevice.Acquisition.mAlertPending);
+
+	//MASK_ENABLE can't be read: the pin stays asserted until INA226_AcquisitionPoll gets through
+	INA226_Mock_FailTransactions(&gINA226_HostBus, 0, 3);
+	INA226_AlertPinISR(&gDevice);
+	CHECK(gDevice.Acquisition.mAlertPending);
+	INA226_AcquisitionPoll(&gDevice);
+	INA226_AcquisitionPoll(&gDevice);
+	CHECK(gDevice.Acquisition.mAlertPending);
+	CHECK_EQUAL(gDevice.Acquisition.mErrors, 4);
+	INA226_AcquisitionPoll(&gDevice);
+	INA226_Mock_Complete(&gINA226_HostBus, &gDevice);
+	CHECK(!gDevice.Acquisition.mAlertPending);
+	CHECK_EQUAL(gDevice.Acquisition.mSamples, 2);
+
+	//Nothing pending: no bus access
+	INA226_Mock_ResetCounters(&gINA226_HostBus);
+	INA226_AcquisitionPoll(&gDevice);
+	CHECK_TRAFFIC(0, 0);
+	CHECK_EQUAL(INA226_StopConversionReadyAcquisition(&gDevice), OK);
+}
+//----------------------------------------------------------------------------
+//Encoders
+
+static void Test_DeltaRoundTrip(void)
+{
+	Test_Setup();
+	Test_FillSamples();
+	INA226_delta theDelta;
+	INA226_delta_decoder theDecoder;
+
+	//No deadband: every sample comes back unchanged
+	CHECK_EQUAL(INA226_Delta_Init(&theDelta, &gDevice.Config, 0, 0, 0, 0, 0), OK);
+	uint32_t theConsumed;
+	uint32_t theSize = INA226_Delta_Encode(&theDelta, gSamples, TEST_SAMPLES, gBuffer, sizeof(gBuffer), &theConsumed);
+	CHECK_EQUAL(theConsumed, TEST_SAMPLES);
+	INA226_Delta_DecoderInit(&theDecoder);
+	uint32_t theUsed;
+	CHECK_EQUAL(INA226_Delta_Decode(&theDecoder, gBuffer, theSize, gDecoded, TEST_SAMPLES, &theUsed), TEST_SAMPLES);
+	CHECK_EQUAL(theUsed, theSize);
+	CHECK(memcmp(gDecoded, gSamples, sizeof(gSamples)) == 0);
+
+	//Deadband: every sample is within the deadband of the last one decoded before or at it
+	uint32_t thePowerLSB = (uint32_t)gDevice.Config.mPowerMicroWattPerBit;
+	uint32_t theCurrentLSB = (uint32_t)gDevice.Config.mCurrentMicroAmpsPerBit;
+	CHECK_EQUAL(INA226_Delta_Init(&theDelta, &gDevice.Config, 25, 5000, 8 * thePowerLSB, 8 * theCurrentLSB, 50000), OK);
+	theSize = INA226_Delta_Encode(&theDelta, gSamples, TEST_SAMPLES, gBuffer, sizeof(gBuffer), &theConsumed);
+	CHECK_EQUAL(theConsumed, TEST_SAMPLES);
+	INA226_Delta_DecoderInit(&theDecoder);
+	uint32_t theCount = INA226_Delta_Decode(&theDecoder, gBuffer, theSize, gDecoded, TEST_SAMPLES, NULL);
+	CHECK(theCount > 1 && theCount < TEST_SAMPLES / 2);
+	CHECK(memcmp(&gDecoded[0], &gSamples[0], sizeof(INA226_sample)) == 0); //key frame
+	uint32_t theDecodedIdx = 0;
+	for(uint32_t i = 0; i < TEST_SAMPLES; i++){
+		while(theDecodedIdx + 1 < theCount && gDecoded[theDecodedIdx + 1].Timestamp <= gSamples[i].Timestamp){
+			theDecodedIdx++;
+		}
+		const INA226_raw* theSent = &gSamples[i].Raw;
+		const INA226_raw* theReported = &gDecoded[theDecodedIdx].Raw;
+		int32_t theErrors[4] = {theSent->ShuntVoltage - theReported->ShuntVoltage, (int32_t)theSent->BusVoltage - theReported->BusVoltage,
+								(int32_t)theSent->Power - theReported->Power, theSent->Current - theReported->Current};
+		for(uint8_t k = 0; k < 4; k++){
+			CHECK(theErrors[k] >= -(int32_t)theDelta.mDeadband[k] && theErrors[k] <= (int32_t)theDelta.mDeadband[k]);
+		}
+		CHECK(gSamples[i].Timestamp - gDecoded[theDecodedIdx].Timestamp <= 50000);
+	}
+}
+
+//Corrupt records on the link: dropped and counted, decoding resyncs on the next key frame
+static void Test_DeltaCorrupt(void)
+{
+	Test_Setup();
+	Test_FillSamples();
+	INA226_delta theDelta;
+	INA226_delta_decoder theDecoder;
+	CHECK_EQUAL(INA226_Delta_Init(&theDelta, &gDevice.Config, 0, 0, 0, 0, 0), OK);
+	uint32_t theSize = INA226_Delta_Encode(&theDelta, gSamples, 10, gBuffer, sizeof(gBuffer), NULL);
+	//A 5th timestamp byte above 0x0F, then a 5th byte with the continuation bit
+	static const uint8_t cCorrupt[] = {0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x7F, 0x02, 0xF0, 0xF0, 0xF0, 0xF0, 0x90, 0x70};
+	memcpy(&gBuffer[theSize], cCorrupt, sizeof(cCorrupt));
+	theSize += sizeof(cCorrupt);
+	//A delta record, skipped until the key frame
+	theSize += INA226_Delta_Encode(&theDelta, &gSamples[10], 1, &gBuffer[theSize], sizeof(gBuffer) - theSize, NULL);
+	INA226_Delta_Reset(&theDelta);
+	theSize += INA226_Delta_Encode(&theDelta, &gSamples[11], 10, &gBuffer[theSize], sizeof(gBuffer) - theSize, NULL);
+
+	INA226_Delta_DecoderInit(&theDecoder);
+	uint32_t theUsed;
+	CHECK_EQUAL(INA226_Delta_Decode(&theDecoder, gBuffer, theSize, gDecoded, TEST_SAMPLES, &theUsed), 20);
+	CHECK_EQUAL(theUsed, theSize);
+	CHECK(theDecoder.mCorrupt >= 2);
+	CHECK(memcmp(gDecoded, gSamples, 10 * sizeof(INA226_sample)) == 0);
+	CHECK(memcmp(&gDecoded[10], &gSamples[11], 10 * sizeof(INA226_sample)) == 0);
+
+	//A record cut at the end is still left for the next buffer, not dropped
+	INA226_Delta_DecoderInit(&theDecoder);
+	INA226_Delta_Reset(&theDelta);
+	theSize = INA226_Delta_Encode(&theDelta, gSamples, 2, gBuffer, sizeof(gBuffer), NULL);
+	CHECK_EQUAL(INA226_Delta_Decode(&theDecoder, gBuffer, theSize - 1, gDecoded, TEST_SAMPLES, &theUsed), 1);
+	CHECK(theUsed < theSize - 1);
+	CHECK_EQUAL(theDecoder.mCorrupt, 0);
+	CHECK_EQUAL(INA226_Delta_Decode(&theDecoder, &gBuffer[theUsed], theSize - theUsed, &gDecoded[1], TEST_SAMPLES, NULL), 1);
+	CHECK(memcmp(gDecoded, gSamples, 2 * sizeof(INA226_sample)) == 0);
+}
+
+static void Test_RecordRoundTrip(void)
+{
+	Test_Setup();
+	Test_FillSamples();
+	uint32_t thePacked;
+	uint32_t theSize = INA226_Record_Pack(&gDevice.Config, 3, gSamples, TEST_SAMPLES, gBuffer, sizeof(gBuffer), &thePacked);
+	CHECK_EQUAL(thePacked, INA226_RECORD_MAX_COUNT);
+	CHECK_EQUAL(theSize, INA226_RECORD_HEADER_SIZE + INA226_RECORD_MAX_COUNT * INA226_RECORD_SIZE);
+
+	INA226_record_header theHeader;
+	uint32_t theBlockSize;
+	CHECK_EQUAL(INA226_Record_ParseHeader(gBuffer, theSize, &theHeader, &theBlockSize), OK);
+	CHECK_EQUAL(theBlockSize, theSize);
+	CHECK_EQUAL(theHeader.mVersion, INA226_RECORD_VERSION);
+	CHECK_EQUAL(theHeader.mDeviceId, 3);
+	CHECK_EQUAL(theHeader.mConfigRegister, gDevice.Config.mConfigRegister);
+	CHECK_EQUAL(theHeader.mCalibration, gDevice.Config.mCalibrationValue);
+	CHECK_EQUAL(theHeader.mConfigHash, INA226_Record_ConfigHash(&gDevice.Config));
+	CHECK_EQUAL(INA226_Record_Unpack(&theHeader, gBuffer, gDecoded, TEST_SAMPLES), INA226_RECORD_MAX_COUNT);
+	CHECK(memcmp(gDecoded, gSamples, INA226_RECORD_MAX_COUNT * sizeof(INA226_sample)) == 0);
+
+	INA226_config theScaling;
+	memset(&theScaling, 0, sizeof(theScaling));
+	INA226_Record_Scaling(&theHeader, &theScaling);
+	CHECK_EQUAL(theScaling.mCurrentMicroAmpsPerBit, gDevice.Config.mCurrentMicroAmpsPerBit);
+	CHECK_EQUAL(theScaling.mPowerMicroWattPerBit, gDevice.Config.mPowerMicroWattPerBit);
+
+	//Cut or foreign blocks are refused
+	CHECK(INA226_Record_ParseHeader(gBuffer, theSize - 1, &theHeader, NULL) != OK);
+	gBuffer[0] ^= 0xFF;
+	CHECK(INA226_Record_ParseHeader(gBuffer, theSize, &theHeader, NULL) != OK);
+}
+
+static void Test_PlanTable(void)
+{
+	static const struct{
+		uint32_t	mPeriod_us;
+		uint32_t	mNoise_nV;
+		status		mResult;
+		uint16_t	mConfig;
+		uint16_t	mOversampling;
+	} cCases[] = {
+		{35200,		0,		OK,				0x4527,	1},	//the default configuration
+		{1000,		0,		OK,				0x4097,	1},
+		{100000,	800,	OK,				0x4897,	1},
+		{1000,		100,	CONFIG_ERROR,	0x4007,	3},	//unreachable, lowest noise plan
+		{10000,		500,	CONFIG_ERROR,	0x4097,	15},
+		{140,		0,		BAD_PARAMETER,	0,		0},	//shorter than the fastest conversion
+	};
+	for(size_t i = 0; i < sizeof(cCases) / sizeof(cCases[0]); i++){
+		INA226_plan thePlan;
+		status theResult = INA226_Plan(cCases[i].mPeriod_us, cCases[i].mNoise_nV, ShuntAndBusVoltageContinuous, &thePlan);
+		CHECK_EQUAL(theResult, cCases[i].mResult);
+		if(theResult == BAD_PARAMETER){
+			continue;
+		}
+		CHECK_EQUAL(thePlan.mConfigRegister, cCases[i].mConfig);
+		CHECK_EQUAL(thePlan.mOversampling, cCases[i].mOversampling);
+		CHECK_EQUAL(thePlan.mConversionPeriod_us, INA226_ConfigConversionPeriod_us(thePlan.mConfigRegister));
+		CHECK(thePlan.mConversionPeriod_us <= thePlan.mReadPeriod_us);
+		CHECK(thePlan.mReadPeriod_us * thePlan.mOversampling <= cCases[i].mPeriod_us);
+		CHECK_EQUAL(thePlan.mNoise_nV, INA226_Plan_Noise_nV(thePlan.mConfigRegister, thePlan.mOversampling));
+		uint16_t theEncoded;
+		CHECK_EQUAL(INA226_EncodeSettings(&thePlan.mSettings, &theEncoded), OK);
+		CHECK_EQUAL(theEncoded, thePlan.mConfigRegister);
+	}
+	CHECK_EQUAL(INA226_Plan(35200, 0, Shutdown, NULL), BAD_PARAMETER);
+	CHECK_EQUAL(INA226_Plan(35200, 0, ShuntVoltageTriggered, NULL), BAD_PARAMETER);
+	CHECK_EQUAL(INA226_Plan(35200, 0, ShuntAndBusTriggered, NULL), BAD_PARAMETER);
+}
+//----------------------------------------------------------------------------
+//Modules on top of the engine
+
+//Advances the clock in aStep_us steps up to aUntil_us, completing the transfers of the bus
+static void Test_RunBus(INA226_Bus* aBus, uint32_t aUntil_us, uint32_t aStep_us)
+{
+	while((int32_t)(aUntil_us - gNow) > 0){
+		gNow += aStep_us;
+		INA226_Bus_Poll(aBus);
+		while(INA226_Mock_TakePending(&gINA226_HostBus)){
+			INA226_Bus_TransferComplete(aBus);
+		}
+	}
+}
+
+static void Test_BusSchedule(void)
+{
+	Test_Setup();
+	INA226_Bus theBus;
+	CHECK_EQUAL(INA226_Bus_Init(&theBus, Test_Clock, NULL), OK);
+	for(uint8_t i = 0; i < 2; i++){
+		CHECK_EQUAL(INA226_InitFixedPoint(&gDevices[i], NULL, NULL, INA226_ADRESS_0 + i, TEST_SHUNT_UOHMS, TEST_MAX_UA), OK);
+		CHECK_EQUAL(INA226_Bus_Add(&theBus, &gDevices[i], 10000, 0, MeasureCurrent | MeasureBusVoltage), OK);
+	}
+	INA226_Mock_ResetCounters(&gINA226_HostBus);
+	Test_RunBus(&theBus, 100000, 500);
+	CHECK_EQUAL(theBus.mEntries[0].mSamples, 11); //0, 10ms .. 100ms
+	CHECK_EQUAL(theBus.mEntries[1].mSamples, 11);
+	CHECK_EQUAL(theBus.mEntries[0].mMissed + theBus.mEntries[1].mMissed, 0);
+	CHECK_TRAFFIC(44, 220);
+	CHECK_EQUAL(theBus.mActive, -1);
+	CHECK_EQUAL(gDevices[1].Result.BusVoltage_uV, TEST_BUS_UV);
+}
+
+static uint32_t gSnapshots;
+static status gSnapshotStatus;
+
+static void Test_OnSnapshot(INA226_Bus* aBus, status aStatus)
+{
+	gSnapshots++;
+	gSnapshotStatus = aStatus;
+}
+
+static void Test_BusSnapshot(void)
+{
+	Test_Setup();
+	INA226_Bus theBus;
+	CHECK_EQUAL(INA226_Bus_Init(&theBus, Test_Clock, NULL), OK);
+	for(uint8_t i = 0; i < 3; i++){
+		CHECK_EQUAL(INA226_InitFixedPoint(&gDevices[i], NULL, NULL, INA226_ADRESS_0 + i, TEST_SHUNT_UOHMS, TEST_MAX_UA), OK);
+		CHECK_EQUAL(INA226_Bus_Add(&theBus, &gDevices[i], 1000000, 0, MeasureCurrent), OK);
+		INA226_Mock_SetInput(&gINA226_HostBus, INA226_ADRESS_0 + i, 10000 * (i + 1), TEST_BUS_UV);
+	}
+	gNow = 1; //the periodic samples are due at 0
+	Test_RunBus(&theBus, 2, 1);
+	const uint16_t theConfig = gDevices[0].Config.mConfigRegister;
+	gSnapshots = 0;
+	CHECK_EQUAL(INA226_Bus_StartSnapshot(&theBus, MeasureShuntVoltage | MeasureCurrent, Test_OnSnapshot), OK);
+	Test_RunBus(&theBus, 200000, 1000);
+	CHECK_EQUAL(gSnapshots, 1);
+	CHECK_EQUAL(gSnapshotStatus, OK);
+	CHECK(!INA226_Bus_SnapshotIsBusy(&theBus));
+	for(uint8_t i = 0; i < 3; i++){
+		CHECK_EQUAL(gDevices[i].Result.ShuntVoltage_uV, 10000 * (i + 1));
+		CHECK_EQUAL(theBus.mEntries[i].mSamples, 2);
+		//Back in the continuous mode of before
+		CHECK_EQUAL(Test_MockDevice(i)->mRegisters[INA226_CONFIG_REG], theConfig);
+		CHECK_EQUAL(gDevices[i].Config.mConfigRegister, theConfig);
+	}
+
+	//The read of the second device fails: the harvest stops, all triggered devices are restored
+	INA226_Mock_FailTransactions(&gINA226_HostBus, 4, 1);
+	CHECK_EQUAL(INA226_Bus_StartSnapshot(&theBus, MeasureCurrent, Test_OnSnapshot), OK);
+	Test_RunBus(&theBus, gNow + 200000, 1000);
+	CHECK_EQUAL(gSnapshots, 2);
+	CHECK_EQUAL(gSnapshotStatus, FAIL);
+	for(uint8_t i = 0; i < 3; i++){
+		CHECK_EQUAL(Test_MockDevice(i)->mRegisters[INA226_CONFIG_REG], theConfig);
+		CHECK(!theBus.mEntries[i].mInSnapshot);
+	}
+	CHECK_EQUAL(theBus.mEntries[1].mErrors, 1);
+}
+
+static uint32_t gCaptureHalves;
+static int16_t gCaptureLast;
+
+static void Test_OnCaptureHalf(INA226_capture* aCapture, const int16_t* aSamples, uint16_t aCount)
+{
+	gCaptureHalves++;
+	gCaptureLast = aSamples[aCount - 1];
+}
+
+//The mock has no ALERT pin, a tick stands in for the pacing event
+static void Test_CaptureSample(INA226_capture* aCapture)
+{
+	INA226_Capture_Tick(aCapture);
+	while(INA226_Mock_TakePending(&gINA226_HostBus)){
+		INA226_Capture_TransferComplete(aCapture);
+	}
+}
+
+static void Test_CaptureTimer(void)
+{
+	Test_Setup();
+	INA226_capture theCapture;
+	int16_t theBuffer[8];
+	uint32_t thePeriod;
+	gCaptureHalves = 0;
+	CHECK_EQUAL(INA226_Capture_Start(&theCapture, &gDevice, INA226_SHUNT_VOLTAGE_REG, CapturePacedByTimer, theBuffer, 8,
+		Test_OnCaptureHalf, Test_OnCaptureHalf, &thePeriod), OK);
+	CHECK_EQUAL(thePeriod, 35200);
+	CHECK_TRAFFIC(1, 2); //the pointer write
+	CHECK_EQUAL(INA226_MeasureAsync(&gDevice, MeasureCurrent, NULL), INA226_BUSY);
+
+	INA226_Mock_ResetCounters(&gINA226_HostBus);
+	uint32_t theTransactions = gDevice.Config.mBusTransactions;
+	for(int i = 0; i < 8; i++){
+		Test_CaptureSample(&theCapture);
+	}
+	CHECK_TRAFFIC(8, 24); //2 byte reads without pointer writes
+	CHECK_EQUAL(gDevice.Config.mBusTransactions - theTransactions, 8);
+	CHECK_EQUAL(gCaptureHalves, 2);
+	CHECK_EQUAL(gCaptureLast, TEST_SHUNT_UV * 2 / 5);
+	CHECK_EQUAL(theCapture.mSamples, 8);
+
+	//The failure policy of the device applies: degraded after 2 failures, then the reads are skipped
+	CHECK_EQUAL(INA226_SetFailurePolicy(&gDevice.Config, 0, 2), OK);
+	INA226_Mock_FailTransactions(&gINA226_HostBus, 0, 2);
+	Test_CaptureSample(&theCapture);
+	Test_CaptureSample(&theCapture);
+	CHECK(INA226_IsDegraded(&gDevice.Config));
+	INA226_Mock_ResetCounters(&gINA226_HostBus);
+	Test_CaptureSample(&theCapture);
+	CHECK_TRAFFIC(0, 0);
+	CHECK_EQUAL(theCapture.mErrors, 3);
+	CHECK_EQUAL(theCapture.mSamples, 8);
+	CHECK_EQUAL(INA226_Capture_Stop(&theCapture), OK);
+	CHECK(!INA226_AsyncIsBusy(&gDevice));
+}
+
+static void Test_CaptureDrain(INA226_capture* aCapture)
+{
+	while(INA226_Mock_TakePending(&gINA226_HostBus)){
+		INA226_Capture_TransferComplete(aCapture);
+	}
+}
+
+static void Test_CaptureConversionReady(void)
+{
+	Test_Setup();
+	INA226_capture theCapture;
+	int16_t theBuffer[8];
+	gCaptureHalves = 0;
+	CHECK_EQUAL(INA226_Capture_Start(&theCapture, &gDevice, INA226_SHUNT_VOLTAGE_REG, CapturePacedByConversionReady, theBuffer, 8,
+		Test_OnCaptureHalf, Test_OnCaptureHalf, NULL), OK);
+
+	//An edge during the read: that conversion is read right after it, the pin released
+	INA226_Mock_ResetCounters(&gINA226_HostBus);
+	INA226_Capture_AlertISR(&theCapture);
+	INA226_Capture_AlertISR(&theCapture);
+	Test_CaptureDrain(&theCapture);
+	CHECK_EQUAL(theCapture.mOverruns, 1);
+	CHECK_EQUAL(theCapture.mSamples, 2);
+	CHECK(!theCapture.mAlertPending);
+	CHECK_TRAFFIC(4, 20);
+
+	//The flags read fails in the ALERT interrupt: the poll reads it
+	INA226_Mock_FailTransactions(&gINA226_HostBus, 0, 1);
+	INA226_Capture_AlertISR(&theCapture);
+	CHECK(theCapture.mAlertPending);
+	INA226_Capture_Poll(&theCapture);
+	Test_CaptureDrain(&theCapture);
+	CHECK_EQUAL(theCapture.mSamples, 3);
+
+	//The sample read fails: retried from the completion, flags first
+	INA226_Mock_FailTransactions(&gINA226_HostBus, 1, 1);
+	INA226_Capture_AlertISR(&theCapture);
+	Test_CaptureDrain(&theCapture);
+	CHECK_EQUAL(theCapture.mSamples, 4);
+	CHECK_EQUAL(theCapture.mErrors, 2);
+	CHECK_EQUAL(gCaptureHalves, 1);
+	CHECK(!theCapture.mAlertPending);
+
+	//Nothing pending: no traffic. No new conversion: no sample
+	INA226_Mock_ResetCounters(&gINA226_HostBus);
+	INA226_Capture_Poll(&theCapture);
+	CHECK_TRAFFIC(0, 0);
+	Test_MockDevice(0)->mNotReadyPolls = 1;
+	INA226_Capture_AlertISR(&theCapture);
+	Test_CaptureDrain(&theCapture);
+	CHECK_TRAFFIC(1, 5);
+	CHECK_EQUAL(theCapture.mSamples, 4);
+	CHECK_EQUAL(INA226_Capture_Stop(&theCapture), OK);
+	CHECK(!INA226_AsyncIsBusy(&gDevice));
+}
+
+static uint32_t gAlerts;
+static uint8_t gAlertStep;
+
+static void Test_OnAlert(INA226_supervisor* aSupervisor, uint8_t aStep, enum eAlertTriggerCause aCause)
+{
+	gAlerts++;
+	gAlertStep = aStep;
+}
+
+//The mock has no comparator, the alert function flag is set by hand
+static void Test_RaiseAlert(INA226_supervisor* aSupervisor)
+{
+	Test_MockDevice(0)->mRegisters[INA226_MASK_ENABLE_REG] |= AlertFunctionFlag;
+	INA226_Supervisor_AlertISR(aSupervisor);
+	INA226_Mock_Complete(&gINA226_HostBus, &gDevice);
+}
+
+static void Test_Supervisor(void)
+{
+	Test_Setup();
+	INA226_supervisor theSupervisor;
+	const INA226_alert_step theSteps[2] = {
+		{ShuntVoltageOverLimit, INA226_Supervisor_CurrentLimit_uV(&gDevice.Config, 1000000), 1},
+		{ShuntVoltageOverLimit, INA226_Supervisor_CurrentLimit_uV(&gDevice.Config, 2000000), INA226_SUPERVISOR_STOP}};
+	CHECK_EQUAL(theSteps[0].mLimit, 100000); //1A through 0.1 Ohm
+	CHECK_EQUAL(INA226_Supervisor_Init(&theSupervisor, &gDevice, theSteps, 2, Test_OnAlert), OK);
+	CHECK_EQUAL(INA226_Supervisor_Arm(&theSupervisor, 0), OK);
+	CHECK_EQUAL(Test_MockDevice(0)->mRegisters[INA226_MASK_ENABLE_REG], theSupervisor.mMaskEnable[0]);
+	CHECK_EQUAL(Test_MockDevice(0)->mRegisters[INA226_ALERT_LIMIT_REG], theSupervisor.mAlertLimit[0]);
+
+	gAlerts = 0;
+	INA226_Mock_ResetCounters(&gINA226_HostBus);
+	Test_RaiseAlert(&theSupervisor);
+	CHECK_EQUAL(gAlerts, 1);
+	CHECK_EQUAL(gAlertStep, 0);
+	CHECK_EQUAL(theSupervisor.mArmed, 1);
+	CHECK_TRAFFIC(3, 13); //cause read, limit and MASK_ENABLE writes
+	CHECK_EQUAL(Test_MockDevice(0)->mRegisters[INA226_ALERT_LIMIT_REG], theSupervisor.mAlertLimit[1]);
+
+	Test_RaiseAlert(&theSupervisor);
+	CHECK_EQUAL(gAlerts, 2);
+	CHECK_EQUAL(gAlertStep, 1);
+	CHECK_EQUAL(theSupervisor.mArmed, INA226_SUPERVISOR_STOP);
+	CHECK_EQUAL(Test_MockDevice(0)->mRegisters[INA226_MASK_ENABLE_REG] & 0xFC00, 0);
+	CHECK_EQUAL(theSupervisor.mErrors, 0);
+
+	//Not an alert of ours: no callback
+	INA226_Supervisor_AlertISR(&theSupervisor);
+	INA226_Mock_Complete(&gINA226_HostBus, &gDevice);
+	CHECK_EQUAL(gAlerts, 2);
+
+	//The cause read can't be started: the alert stays pending until the poll
+	CHECK_EQUAL(INA226_Supervisor_Arm(&theSupervisor, 0), OK);
+	Test_MockDevice(0)->mRegisters[INA226_MASK_ENABLE_REG] |= AlertFunctionFlag;
+	INA226_Mock_FailTransactions(&gINA226_HostBus, 0, 1);
+	INA226_Supervisor_AlertISR(&theSupervisor);
+	CHECK(theSupervisor.mPending);
+	INA226_Supervisor_Poll(&theSupervisor);
+	INA226_Mock_Complete(&gINA226_HostBus, &gDevice);
+	CHECK_EQUAL(gAlerts, 3);
+	CHECK_EQUAL(gAlertStep, 0);
+	CHECK(!theSupervisor.mPending);
+
+	//The cause read fails on the bus: retried from the error interrupt, then from the poll
+	Test_MockDevice(0)->mRegisters[INA226_MASK_ENABLE_REG] |= AlertFunctionFlag;
+	INA226_Supervisor_AlertISR(&theSupervisor);
+	for(int i = 0; i < 3; i++){
+		CHECK(INA226_AsyncIsBusy(&gDevice));
+		while(INA226_Mock_TakePending(&gINA226_HostBus)){
+			//dropped, the error interrupt follows
+		}
+		Test_MockDevice(0)->mRegisters[INA226_MASK_ENABLE_REG] |= AlertFunctionFlag; //the read never reached the device
+		INA226_AsyncTransferError(&gDevice);
+	}
+	CHECK(!INA226_AsyncIsBusy(&gDevice));
+	CHECK(theSupervisor.mPending);
+	CHECK_EQUAL(theSupervisor.mErrors, 3);
+	INA226_Supervisor_Poll(&theSupervisor);
+	INA226_Mock_Complete(&gINA226_HostBus, &gDevice);
+	CHECK_EQUAL(gAlerts, 4);
+	CHECK_EQUAL(gAlertStep, 1);
+	CHECK_EQUAL(theSupervisor.mFailures, 0);
+}
+
+//A bus and a supervisor drive the same device, each callback finds its own state
+static void Test_SharedDevice(void)
+{
+	Test_Setup();
+	INA226_Bus theBus;
+	INA226_Bus theOtherBus;
+	CHECK_EQUAL(INA226_Bus_Init(&theBus, Test_Clock, NULL), OK);
+	CHECK_EQUAL(INA226_Bus_Init(&theOtherBus, Test_Clock, NULL), OK);
+	CHECK_EQUAL(INA226_Bus_Add(&theBus, &gDevice, 10000, 0, MeasureCurrent), OK);
+	CHECK_EQUAL(INA226_Bus_Add(&theOtherBus, &gDevice, 10000, 0, MeasureCurrent), INA226_BUSY);
+
+	INA226_supervisor theSupervisor;
+	const INA226_alert_step theStep = {ShuntVoltageOverLimit, INA226_Supervisor_CurrentLimit_uV(&gDevice.Config, 1000000), INA226_SUPERVISOR_STAY};
+	CHECK_EQUAL(INA226_Supervisor_Init(&theSupervisor, &gDevice, &theStep, 1, Test_OnAlert), OK);
+	CHECK_EQUAL(INA226_Supervisor_Arm(&theSupervisor, 0), OK);
+
+	Test_RunBus(&theBus, gNow + 25000, 1000);
+	CHECK_EQUAL(theBus.mEntries[0].mSamples, 3);
+	gAlerts = 0;
+	Test_RaiseAlert(&theSupervisor);
+	CHECK_EQUAL(gAlerts, 1);
+	CHECK_EQUAL(theSupervisor.mErrors, 0);
+	Test_RunBus(&theBus, gNow + 10000, 1000);
+	CHECK_EQUAL(theBus.mEntries[0].mSamples, 4);
+	CHECK_EQUAL(theBus.mEntries[0].mErrors, 0);
+}
+
+static void Test_Adaptive(void)
+{
+	Test_Setup();
+	INA226_adaptive theAdaptive;
+	const INA226_settings theFast = {0, 1, 1, ShuntAndBusVoltageContinuous};
+	const INA226_settings theSteady = {3, 4, 4, ShuntAndBusVoltageContinuous};
+	CHECK_EQUAL(INA226_Adaptive_Init(&theAdaptive, &gDevice, &theFast, &theSteady, 1000, 10000), OK);
+	CHECK_EQUAL(Test_MockDevice(0)->mRegisters[INA226_CONFIG_REG], theAdaptive.mFastConfig);
+
+	INA226_raw theRaw = {0, 9600, 1000, 1000};
+	uint32_t theQuiet = 1 + INA226_ADAPTIVE_WINDOW * INA226_ADAPTIVE_QUIET_WINDOWS; //the first one is skipped
+	for(uint32_t i = 0; i < theQuiet - 1; i++){
+		theRaw.Current = (int16_t)(1000 + (i & 1));
+		CHECK_EQUAL(INA226_Adaptive_Add(&theAdaptive, &theRaw), OK);
+	}
+	CHECK(!INA226_Adaptive_IsSteady(&theAdaptive));
+	CHECK_EQUAL(INA226_Adaptive_Add(&theAdaptive, &theRaw), OK);
+	CHECK(INA226_Adaptive_IsSteady(&theAdaptive));
+	CHECK_EQUAL(Test_MockDevice(0)->mRegisters[INA226_CONFIG_REG], theAdaptive.mSteadyConfig);
+
+	//A step of more than 10mA is a transient, back to the fast settings
+	INA226_Adaptive_Add(&theAdaptive, &theRaw); //skipped after the switch
+	theRaw.Current = 1000 + 10000 / (int16_t)gDevice.Config.mCurrentMicroAmpsPerBit + 1;
+	CHECK_EQUAL(INA226_Adaptive_Add(&theAdaptive, &theRaw), OK);
+	CHECK(!INA226_Adaptive_IsSteady(&theAdaptive));
+	CHECK_EQUAL(Test_MockDevice(0)->mRegisters[INA226_CONFIG_REG], theAdaptive.mFastConfig);
+	CHECK_EQUAL(theAdaptive.mSwitches, 2);
+}
+static void Test_Energy(void)
+{
+	Test_Setup();
+	INA226_energy theEnergy;
+	INA226_energy_reading theReading;
+	CHECK_EQUAL(INA226_Energy_Init(&theEnergy, &gDevice.Config), OK);
+	INA226_Energy_Get(&theEnergy, &theReading);
+	CHECK_EQUAL(theReading.Elapsed_us, 0);
+	const INA226_raw theRaw = {0, 9600, 1000, 1000};
+	for(int i = 0; i < 1000; i++){
+		INA226_Energy_Add(&theEnergy, &theRaw, 1);
+	}
+	uint64_t theElapsed = 1000ull * theEnergy.mPeriod_us;
+	INA226_Energy_Get(&theEnergy, &theReading);
+	CHECK_EQUAL(theReading.Elapsed_us, theElapsed);
+	CHECK_EQUAL(theReading.Charge_uAh, (int64_t)(1000 * gDevice.Config.mCurrentMicroAmpsPerBit * theElapsed / 3600000000ull));
+	CHECK_EQUAL(theReading.Energy_uWh, 1000 * gDevice.Config.mPowerMicroWattPerBit * theElapsed / 3600000000ull);
+	//The reading of the previous update is kept until the next one
+	CHECK_EQUAL(theEnergy.mPublished[(theEnergy.mPublications + 1) & 1].Elapsed_us, theElapsed - theEnergy.mPeriod_us);
+
+	//Reconfigured to a shorter period: the time integrated so far stays, new samples count less
+	INA226_config theFast = gDevice.Config;
+	theFast.mConfigRegister = (uint16_t)((theFast.mConfigRegister & ~0x0FF8u) | 0x0048u); //1 sample, 204us
+	CHECK_EQUAL(INA226_Energy_Sync(&theEnergy, &theFast), OK);
+	CHECK(theEnergy.mPeriod_us < theElapsed / 1000);
+	INA226_Energy_Get(&theEnergy, &theReading);
+	CHECK_EQUAL(theReading.Elapsed_us, theElapsed);
+	for(int i = 0; i < 500; i++){
+		INA226_Energy_Add(&theEnergy, &theRaw, 1);
+	}
+	theElapsed += 500ull * theEnergy.mPeriod_us;
+	INA226_Energy_Get(&theEnergy, &theReading);
+	CHECK_EQUAL(theReading.Elapsed_us, theElapsed);
+	CHECK_EQUAL(theReading.Charge_uAh, (int64_t)(1000 * gDevice.Config.mCurrentMicroAmpsPerBit * theElapsed / 3600000000ull));
+	CHECK_EQUAL(theEnergy.mWrites[0] & 1, 0); //no update in progress
+	CHECK_EQUAL(theEnergy.mWrites[0] + theEnergy.mWrites[1], 2 * theEnergy.mPublications);
+	INA226_Energy_Reset(&theEnergy);
+	INA226_Energy_Get(&theEnergy, &theReading);
+	CHECK_EQUAL(theReading.Charge_uAh, 0);
+}
+
+//OSAL hooks without an RTOS: waiting runs the interrupts of the simulated bus and advances the clock
+static bool gOsSignalled;
+static bool gOsHang;				//the transfers never complete
+static uint32_t gOsNow;
+static uint32_t gOsMeasure_ms;		//duration of a measurement, gOsNextMeasure_ms after the first sleep
+static uint32_t gOsNextMeasure_ms;
+static uint32_t gOsAborts;
+static uint32_t gOsWakes[3];
+static uint32_t gOsSleeps;
+static INA226_os_acquisition* gOsAcquisition;
+
+static bool Test_OsLock(void* aMutex, uint32_t aTimeout_ms)
+{
+	return true;
+}
+
+static void Test_OsUnlock(void* aMutex)
+{
+}
+
+static bool Test_OsWait(void* aEvent, uint32_t aTimeout_ms)
+{
+	if(aTimeout_ms != 0 && !gOsSignalled){
+		if(gOsHang){
+			gOsNow += aTimeout_ms;
+			return false;
+		}
+		gOsNow += gOsMeasure_ms;
+		INA226_Mock_Complete(&gINA226_HostBus, &gDevice);
+	}
+	bool theSignalled = gOsSignalled;
+	gOsSignalled = false;
+	return theSignalled;
+}
+
+static void Test_OsSignal(void* aEvent)
+{
+	gOsSignalled = true;
+}
+
+static uint32_t Test_OsNow(void)
+{
+	return gOsNow;
+}
+
+static void Test_OsSleepUntil(uint32_t aWake_ms)
+{
+	if((int32_t)(aWake_ms - gOsNow) > 0){
+		gOsNow = aWake_ms;
+	}
+	gOsWakes[gOsSleeps++] = aWake_ms;
+	gOsMeasure_ms = gOsNextMeasure_ms;
+	if(gOsSleeps == sizeof(gOsWakes) / sizeof(gOsWakes[0])){
+		gOsAcquisition->mStop = true;
+	}
+}
+
+static void Test_OsAbort(INA226* aDevice)
+{
+	while(INA226_Mock_TakePending(&gINA226_HostBus)){
+		//dropped, like a transfer stopped on the peripheral
+	}
+	gOsAborts++;
+}
+
+static void Test_OsSetup(INA226_osal* aOsal)
+{
+	memset(aOsal, 0, sizeof(*aOsal));
+	aOsal->Lock = Test_OsLock;
+	aOsal->Unlock = Test_OsUnlock;
+	aOsal->Wait = Test_OsWait;
+	aOsal->Signal = Test_OsSignal;
+	aOsal->Now_ms = Test_OsNow;
+	aOsal->SleepUntil = Test_OsSleepUntil;
+	aOsal->Abort = Test_OsAbort;
+	gOsSignalled = false;
+	gOsHang = false;
+	gOsNow = 1000;
+	gOsMeasure_ms = 0;
+	gOsNextMeasure_ms = 0;
+	gOsAborts = 0;
+	gOsSleeps = 0;
+}
+
+static void Test_OsAcquisition(void)
+{
+	Test_Setup();
+	INA226_osal theOsal;
+	Test_OsSetup(&theOsal);
+	INA226_os_acquisition theAcquisition;
+	INA226_Os_AcquisitionInit(&theAcquisition, &theOsal, &gDevice, MeasureShuntVoltage | MeasureCurrent, 10);
+	INA226_result theResult;
+	CHECK_EQUAL(INA226_Os_GetLatest(&theAcquisition, &theResult), 0);
+	CHECK_EQUAL(INA226_Os_AcquisitionStep(&theAcquisition), OK);
+	CHECK_EQUAL(INA226_Os_GetLatest(&theAcquisition, &theResult), 1);
+	CHECK_EQUAL(theResult.ShuntVoltage_uV, TEST_SHUNT_UV);
+
+	//The next sample goes to the other slot, the published one stays intact while it is written
+	Test_MockDevice(0)->mShuntRaw = 2000; //5000uV
+	CHECK_EQUAL(INA226_Os_AcquisitionStep(&theAcquisition), OK);
+	CHECK_EQUAL(theAcquisition.mLatest[1].ShuntVoltage_uV, TEST_SHUNT_UV);
+	CHECK_EQUAL(INA226_Os_GetLatest(&theAcquisition, &theResult), 2);
+	CHECK_EQUAL(theResult.ShuntVoltage_uV, 5000);
+	CHECK_EQUAL(theAcquisition.mWrites[0], 2); //even: no write in progress
+	CHECK_EQUAL(theAcquisition.mWrites[1], 2);
+	CHECK_EQUAL(theAcquisition.mErrors, 0);
+}
+
+static void Test_OsTimeout(void)
+{
+	Test_Setup();
+	INA226_osal theOsal;
+	Test_OsSetup(&theOsal);
+	gOsHang = true;
+	CHECK_EQUAL(INA226_Os_Measure(&theOsal, &gDevice, MeasureCurrent, 5), INA226_OS_TIMEOUT);
+	CHECK_EQUAL(gOsAborts, 1);
+	CHECK(!INA226_AsyncIsBusy(&gDevice));
+	gOsHang = false;
+	CHECK_EQUAL(INA226_Os_Measure(&theOsal, &gDevice, MeasureCurrent, 5), OK);
+
+	//Without the hook the device stays busy until the application aborts the transfer
+	theOsal.Abort = NULL;
+	gOsHang = true;
+	CHECK_EQUAL(INA226_Os_Measure(&theOsal, &gDevice, MeasureCurrent, 5), INA226_OS_TIMEOUT);
+	CHECK(INA226_AsyncIsBusy(&gDevice));
+	Test_OsAbort(&gDevice);
+	INA226_AsyncTransferError(&gDevice);
+	CHECK(!INA226_AsyncIsBusy(&gDevice));
+}
+
+static void Test_OsTaskPeriod(void)
+{
+	Test_Setup();
+	INA226_osal theOsal;
+	Test_OsSetup(&theOsal);
+	INA226_os_acquisition theAcquisition;
+	INA226_Os_AcquisitionInit(&theAcquisition, &theOsal, &gDevice, MeasureCurrent, 10);
+	gOsAcquisition = &theAcquisition;
+	//The time of the measurements doesn't shift the period
+	gOsMeasure_ms = gOsNextMeasure_ms = 3;
+	INA226_Os_AcquisitionTask(&theAcquisition);
+	CHECK_EQUAL(gOsWakes[0], 1010);
+	CHECK_EQUAL(gOsWakes[1], 1020);
+	CHECK_EQUAL(gOsWakes[2], 1030);
+	CHECK_EQUAL(theAcquisition.mSamples, 3);
+
+	//A measurement of 2.5 periods: the missed periods are skipped, the phase stays
+	gOsSleeps = 0;
+	gOsNow = 1000;
+	gOsMeasure_ms = 25;
+	theAcquisition.mStop = false;
+	INA226_Os_AcquisitionTask(&theAcquisition);
+	CHECK_EQUAL(gOsWakes[0], 1020);
+	CHECK_EQUAL(gOsWakes[1], 1030);
+	CHECK_EQUAL(gOsWakes[2], 1040);
+}
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+	struct { const char* mName; void (*mTest)(void); } const cTests[] = {
+		{"MeasureAll",					Test_MeasureAll},
+		{"StreamingReads",				Test_StreamingReads},
+		{"TrustedCacheConfigWrite",		Test_TrustedCacheConfigWrite},
+		{"ConfigureAlertPinTrigger",	Test_ConfigureAlertPinTrigger},
+		{"Enumerate",					Test_Enumerate},
+		{"MeasureAsync",				Test_MeasureAsync},
+		{"AlertOverrun",				Test_AlertOverrun},
+		{"AlertReadFailure",			Test_AlertReadFailure},
+		{"DeltaRoundTrip",				Test_DeltaRoundTrip},
+		{"DeltaCorrupt",				Test_DeltaCorrupt},
+		{"RecordRoundTrip",				Test_RecordRoundTrip},
+		{"PlanTable",					Test_PlanTable},
+		{"BusSchedule",					Test_BusSchedule},
+		{"BusSnapshot",					Test_BusSnapshot},
+		{"Reprobe",						Test_Reprobe},
+		{"CaptureTimer",				Test_CaptureTimer},
+		{"CaptureConversionReady",		Test_CaptureConversionReady},
+		{"Supervisor",					Test_Supervisor},
+		{"SharedDevice",				Test_SharedDevice},
+		{"Adaptive",					Test_Adaptive},
+		{"Energy",						Test_Energy},
+		{"OsAcquisition",				Test_OsAcquisition},
+		{"OsTimeout",					Test_OsTimeout},
+		{"OsTaskPeriod",				Test_OsTaskPeriod},
+	};
+	uint32_t theRun = 0;
+	for(size_t i = 0; i < sizeof(cTests) / sizeof(cTests[0]); i++){
+		if(argc > 1 && strstr(cTests[i].mName, argv[1]) == NULL){
+			continue;
+		}
+		gTestName = cTests[i].mName;
+		uint32_t theFailures = gFailures;
+		cTests[i].mTest();
+		printf("%-32s %s\n", gTestName, gFailures == theFailures ? "ok" : "FAILED");
+		theRun++;
+	}
+	printf("%u tests, %u checks, %u failed\n", theRun, gChecks, gFailures);
+	return gFailures == 0 && theRun > 0 ? 0 : 1;
+}